@@ -0,0 +1,115 @@
+#include "spsc_ring.hpp"
+#include "bounded_queue.hpp"
+
+#include <pthread.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+
+/**
+ * Pins thread to CPU, failure is ignored so benchmark runs also on small machines.
+ */
+static void
+pin( std::thread &thread, uint32_t cpu ) {
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( cpu % std::max( std::thread::hardware_concurrency(), 1u ), &set );
+    pthread_setaffinity_np( thread.native_handle(), sizeof( set ), &set );
+}
+
+/**
+ * Runs producer and consumer on two pinned CPUs and reports messages per second.
+ */
+template <typename Producer_T, typename Consumer_T>
+static void
+measure( const char *name, uint64_t messages, Producer_T producer, Consumer_T consumer ) {
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer_thread{ producer }, consumer_thread{ consumer };
+    pin( producer_thread, 0 );
+    pin( consumer_thread, 1 );
+    producer_thread.join();
+    consumer_thread.join();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf( "%-24s %10.1f M msg/s\n", name, messages / elapsed.count() / 1e6 );
+}
+
+int
+main( int argc, char **argv ) {
+    const uint64_t messages = argc > 1 ? std::strtoull( argv[ 1 ], nullptr, 10 ) : 100000000;
+    constexpr uint32_t capacity = 1 << 14, batch = 64;
+
+    {
+        yarn::SpscRing<uint64_t> ring{ capacity };
+        uint64_t sum = 0;
+        measure( "spsc single", messages,
+                 [&](){ for( uint64_t i = 0; i < messages; i++ ) while( !ring.tryPush( i ) ); },
+                 [&](){
+                     uint64_t item;
+                     for( uint64_t i = 0; i < messages; i++ ) {
+                         while( !ring.tryPop( item ) );
+                         sum += item;
+                     }
+                 } );
+        if( sum != messages * ( messages - 1 ) / 2 )
+            return 1;
+    }
+
+    {
+        yarn::SpscRing<uint64_t> ring{ capacity };
+        uint64_t sum = 0;
+        measure( "spsc batch", messages,
+                 [&](){
+                     uint64_t buffer[ batch ];
+                     for( uint64_t sent = 0; sent < messages; ) {
+                         uint32_t count = static_cast<uint32_t>( std::min<uint64_t>( batch, messages - sent ) );
+                         for( uint32_t i = 0; i < count; i++ )
+                             buffer[ i ] = sent + i;
+                         for( uint32_t pushed = 0; pushed < count; )
+                             pushed += ring.tryPush_n( buffer + pushed, count - pushed );
+                         sent += count;
+                     }
+                 },
+                 [&](){
+                     uint64_t buffer[ batch ];
+                     for( uint64_t received = 0; received < messages; ) {
+                         uint32_t count = ring.tryPop_n( buffer, batch );
+                         for( uint32_t i = 0; i < count; i++ )
+                             sum += buffer[ i ];
+                         received += count;
+                     }
+                 } );
+        if( sum != messages * ( messages - 1 ) / 2 )
+            return 1;
+    }
+
+    {
+        yarn::SpscRing<uint64_t, true> ring{ capacity };
+        uint64_t sum = 0;
+        measure( "spsc blocking", messages,
+                 [&](){ for( uint64_t i = 0; i < messages; i++ ) ring.push( i ); },
+                 [&](){ for( uint64_t i = 0; i < messages; i++ ) sum += ring.pop(); } );
+        if( sum != messages * ( messages - 1 ) / 2 )
+            return 1;
+    }
+
+    {
+        yarn::BoundedQueue<uint64_t> queue{ capacity };
+        uint64_t sum = 0;
+        measure( "mpmc bounded queue", messages,
+                 [&](){ for( uint64_t i = 0; i < messages; i++ ) while( !queue.tryPush( i ) ); },
+                 [&](){
+                     uint64_t item;
+                     for( uint64_t i = 0; i < messages; i++ ) {
+                         while( !queue.tryPop( item ) );
+                         sum += item;
+                     }
+                 } );
+        if( sum != messages * ( messages - 1 ) / 2 )
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "thread_pool.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Reference pool, single task queue guarded by std::mutex, idle workers wait on std::condition_variable.
+ */
+class MutexPool {
+public:
+    explicit MutexPool( uint32_t thread_count ) {
+        for( uint32_t i = 0; i < thread_count; i++ )
+            workers.emplace_back( [this](){ run(); } );
+    }
+
+    /**
+     * Finishes every submitted task, including tasks submitted meanwhile by running tasks.
+     */
+    ~MutexPool() {
+        {
+            std::lock_guard<std::mutex> guard{ mutex };
+            stopping = true;
+        }
+        available.notify_all();
+        for( auto &worker: workers )
+            worker.join();
+    }
+
+    void submit( std::function<void()> task ) {
+        {
+            std::lock_guard<std::mutex> guard{ mutex };
+            tasks.push_back( std::move( task ) );
+        }
+        available.notify_one();
+    }
+
+private:
+    void run() {
+        while( true ) {
+            std::unique_lock<std::mutex> guard{ mutex };
+            available.wait( guard, [this](){ return stopping || !tasks.empty(); } );
+            // worker running task that still submits is alive, it drains the rest
+            if( tasks.empty() )
+                return;
+
+            std::function<void()> task = std::move( tasks.front() );
+            tasks.pop_front();
+            guard.unlock();
+            task();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+
+/**
+ * Leaf task, few rounds of xorshift so that scheduling overhead dominates.
+ */
+static uint64_t
+leaf( uint64_t seed, uint32_t work ) {
+    uint64_t x = seed + 1;
+    for( uint32_t i = 0; i < work; i++ ) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+/**
+ * Submits \a roots tasks from main thread, every root submits \a fanout leaves from worker.
+ * Pool is destroyed inside measurement, its destructor waits for all tasks.
+ */
+template <typename Pool_T>
+static bool
+measure( const char *name, uint32_t threads, uint32_t roots, uint32_t fanout, uint32_t work ) {
+    std::vector<uint64_t> results( static_cast<size_t>( roots ) * fanout );
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        Pool_T pool{ threads };
+        for( uint32_t root = 0; root < roots; root++ )
+            pool.submit( [&pool, &results, root, fanout, work](){
+                for( uint32_t i = 0; i < fanout; i++ ) {
+                    size_t index = static_cast<size_t>( root ) * fanout + i;
+                    pool.submit( [&results, index, work](){ results[ index ] = leaf( index, work ); } );
+                }
+            } );
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf( "%-24s %10.2f M tasks/s\n", name, results.size() / elapsed.count() / 1e6 );
+
+    for( size_t index = 0; index < results.size(); index++ )
+        if( results[ index ] != leaf( index, work ) )
+            return false;
+    return true;
+}
+
+int
+main( int argc, char **argv ) {
+    const uint32_t threads = argc > 1 ? std::strtoul( argv[ 1 ], nullptr, 10 )
+                                      : std::max( std::thread::hardware_concurrency(), 1u );
+    const uint32_t roots = argc > 2 ? std::strtoul( argv[ 2 ], nullptr, 10 ) : 1 << 14;
+    constexpr uint32_t fanout = 64, work = 64;
+
+    std::printf( "%u threads, %u roots, %u leaves per root\n", threads, roots, fanout );
+    if( !measure<yarn::ThreadPool>( "yarn thread pool", threads, roots, fanout, work ) )
+        return 1;
+    if( !measure<MutexPool>( "mutex + condvar pool", threads, roots, fanout, work ) )
+        return 1;
+
+    return 0;
+}
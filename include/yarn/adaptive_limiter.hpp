@@ -0,0 +1,112 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Concurrency limiter adjusting its limit from measured latencies and failures.
+     *
+     * Limit bounds number of operations in flight, like yarn::Semaphore with changing number of units;
+     * permits are stored in Semaphore and waiting threads block on its futex word.
+     * Every finished operation reports its latency to release. Samples are accumulated by atomic
+     * additions without lock; thread which completes window of samples switches recording to second window
+     * and recomputes limit once last sample of the closed window is recorded, so sums and counts match.
+     * @par
+     * AdaptiveLimiter::Algorithm::aimd increases limit by one after window without failure, when at least half
+     * of limit was used, and multiplies limit by backoff ratio after window with failure.
+     * AdaptiveLimiter::Algorithm::gradient compares average latency of window with long term average;
+     * growing latency means queueing in backend and shrinks limit proportionally, stable latency
+     * lets limit grow by square root of limit.
+     * @note Decreased limit takes effect as operations finish; permits in use are never revoked.
+     */
+    class AdaptiveLimiter {
+    public:
+        /**
+         * @brief Algorithm computing new limit from window of samples.
+         */
+        enum class Algorithm {
+            aimd,       /**< Additive increase, multiplicative decrease on failures. */
+            gradient    /**< Limit follows ratio of long term and recent latency. */
+        };
+
+        /**
+         * Constructor of AdaptiveLimiter.
+         * @param [in] algorithm Algorithm adjusting limit.
+         * @param [in] initial_limit Limit before first window is complete, clamped into [min_limit, max_limit].
+         * @param [in] min_limit Lowest limit, must be positive.
+         * @param [in] max_limit Highest limit.
+         * @param [in] window Number of samples limit is recomputed after.
+         * @throws std::invalid_argument if \a min_limit is 0 or greater than \a max_limit.
+         */
+        AdaptiveLimiter( Algorithm algorithm, uint32_t initial_limit,
+                         uint32_t min_limit = 1, uint32_t max_limit = 1000, uint32_t window = 100 );
+
+        AdaptiveLimiter( const AdaptiveLimiter & ) = delete;
+
+        AdaptiveLimiter &operator=( const AdaptiveLimiter & ) = delete;
+
+        /**
+         * Starts operation, blocks while limit of operations is in flight.
+         */
+        void acquire() noexcept;
+
+        /**
+         * Tries, starting operation without blocking.
+         * @return true if operation may start.
+         */
+        [[nodiscard]] bool tryAcquire() noexcept;
+
+        /**
+         * Finishes operation and records its sample.
+         * @param [in] latency_us Duration of operation in us.
+         * @param [in] failed Operation failed or was dropped due to overload.
+         */
+        void release( uint32_t latency_us, bool failed = false ) noexcept;
+
+        /**
+         * Reads current limit atomically.
+         * @return Snapshot of limit.
+         */
+        [[nodiscard]] uint32_t limit() const noexcept;
+
+    protected:
+        /**
+         * Computes new limit from closed window, called only by thread owning updating flag.
+         */
+        void update( uint64_t sum, uint32_t count, uint32_t failed_count ) noexcept;
+
+        /**
+         * Moves permits of semaphore to match new limit.
+         */
+        void resize( uint32_t new_limit ) noexcept;
+
+        /**
+         * @brief Samples of one window; samples are recorded into active window, other one is being closed.
+         */
+        struct Window {
+            uint64_t latency_sum = 0;   /**< Sum of latencies. */
+            uint32_t samples = 0;       /**< Number of samples. */
+            uint32_t failures = 0;      /**< Number of failures. */
+            uint32_t writers = 0;       /**< Threads recording sample, window is read only after they leave. */
+        };
+
+        static constexpr double backoff = 0.9;          /**< Multiplicative decrease of aimd. */
+        static constexpr double tolerance = 1.5;        /**< Latency growth gradient tolerates without decrease. */
+        static constexpr double smoothing = 0.2;        /**< Weight of new gradient limit. */
+
+    private:
+        Semaphore permits;                  /**< Free permits, waiting threads block on it. */
+        uint32_t debt = 0;                  /**< Permits to be withheld from releases after limit decrease. */
+        uint32_t current_limit;             /**< Limit of operations in flight. */
+        Window windows[ 2 ];                /**< Active window and window being closed. */
+        uint32_t active = 0;                /**< Index of window receiving samples. */
+        uint32_t peak_in_flight = 0;        /**< Most operations in flight observed in current window. */
+        uint32_t updating = 0;              /**< Flag of thread recomputing limit. */
+        double estimate;                    /**< Fractional limit, owned by updating thread. */
+        double long_latency = 0;            /**< Long term average latency, owned by updating thread. */
+        Algorithm algorithm;                /**< Algorithm adjusting limit. */
+        uint32_t min_limit;                 /**< Lowest limit. */
+        uint32_t max_limit;                 /**< Highest limit. */
+        uint32_t window;                    /**< Samples per window. */
+    };
+}
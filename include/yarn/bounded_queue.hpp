@@ -0,0 +1,306 @@
+#pragma once
+#include "primitives.hpp"
+#include "event_count.hpp"
+
+#include <memory>
+#include <new>
+#include <utility>
+
+
+namespace yarn {
+    /**
+     * @brief Bounded lock-free multi-producer multi-consumer queue.
+     *
+     * Ring of slots with per-slot sequence numbers (Dmitry Vyukov's bounded queue). Producer claims
+     * position by compare-and-swap of enqueue position and publishes item by storing sequence of its slot,
+     * consumer does the same with dequeue position, so producers and consumers never take a lock.
+     * Every slot and both positions live on own cache line, so neighbouring slots are not falsely shared.
+     * @par
+     * Blocking operations park on EventCount only when queue is full or empty; successful operation
+     * costs single fence and load to find out that nobody is parked.
+     * @tparam T Item type, must be default constructible and nothrow movable.
+     */
+    template <typename T>
+    class BoundedQueue {
+        static_assert( std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>,
+                "Item must be nothrow movable." );
+
+    public:
+        /**
+         * Constructor of BoundedQueue.
+         * @param [in] capacity Minimal capacity, rounded up to power of 2.
+         * @throws std::invalid_argument if \a capacity is greater than 2^31.
+         */
+        explicit BoundedQueue( uint32_t capacity ) {
+            const uint32_t size = _ring_capacity( capacity );
+            mask = size - 1;
+            slots = std::make_unique<Slot[]>( size );
+            for( uint32_t i = 0; i < size; i++ )
+                slots[ i ].sequence = i;
+        }
+
+        ~BoundedQueue() {
+            T item{};
+            while( tryPop( item ) );
+        }
+
+        BoundedQueue( const BoundedQueue & ) = delete;
+
+        BoundedQueue &operator=( const BoundedQueue & ) = delete;
+
+        /**
+         * Tries, pushing item.
+         * @param [in] item Pushed item, moved from only on success.
+         * @return false if queue is full.
+         */
+        template <typename Item_T>
+        [[nodiscard]] bool tryPush( Item_T &&item ) noexcept {
+            if( !enqueue( std::forward<Item_T>( item ) ) )
+                return false;
+            not_empty.notify_one();
+            return true;
+        }
+
+        /**
+         * Tries, popping item.
+         * @param [out] item Popped item.
+         * @return false if queue is empty.
+         */
+        [[nodiscard]] bool tryPop( T &item ) noexcept {
+            if( !dequeue( item ) )
+                return false;
+            not_full.notify_one();
+            return true;
+        }
+
+        /**
+         * Pushes item, blocks while queue is full.
+         * @param [in] item Pushed item.
+         */
+        template <typename Item_T>
+        void push( Item_T &&item ) noexcept {
+            (void) push_wait( std::forward<Item_T>( item ), nullptr );
+        }
+
+        /**
+         * Pops item, blocks while queue is empty.
+         * @return Popped item.
+         */
+        T pop() noexcept {
+            T item{};
+            (void) pop_wait( item, nullptr );
+            return item;
+        }
+
+        /**
+         * Same as BoundedQueue::push but if queue stays full until deadline, exception is raised.
+         * @param [in] item Pushed item, moved from only on success.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @throws yarn::TimeoutExpiredException
+         */
+        template <typename Item_T>
+        void push_until( Item_T &&item, std::chrono::steady_clock::time_point deadline ) {
+            const struct timespec abs_deadline = _to_timespec( deadline );
+            if( !push_wait( std::forward<Item_T>( item ), &abs_deadline ) )
+                throw TimeoutExpiredException( "Timeout expired before push was possible." );
+        }
+
+        /**
+         * Same as BoundedQueue::pop but if queue stays empty until deadline, exception is raised.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @return Popped item.
+         * @throws yarn::TimeoutExpiredException
+         */
+        T pop_until( std::chrono::steady_clock::time_point deadline ) {
+            const struct timespec abs_deadline = _to_timespec( deadline );
+            T item{};
+            if( !pop_wait( item, &abs_deadline ) )
+                throw TimeoutExpiredException( "Timeout expired before pop was possible." );
+            return item;
+        }
+
+        /**
+         * Tries, pushing \a count items, stops at first full slot.
+         * Parked consumers are notified once for whole batch.
+         * @param [in] items Pushed items, moved from if pushed.
+         * @param [in] count Number of items.
+         * @return Number of pushed items, they are prefix of \a items.
+         */
+        [[nodiscard]] uint32_t tryPush_n( T *items, uint32_t count ) noexcept {
+            uint32_t pushed = 0;
+            while( pushed < count && enqueue( std::move( items[ pushed ] ) ) )
+                pushed++;
+
+            if( pushed == 1 )
+                not_empty.notify_one();
+            else if( pushed > 1 )
+                not_empty.notify_all();
+            return pushed;
+        }
+
+        /**
+         * Pushes \a count items, blocks while queue is full.
+         * @param [in] items Pushed items, moved from.
+         * @param [in] count Number of items.
+         */
+        void push_n( T *items, uint32_t count ) noexcept {
+            uint32_t pushed = tryPush_n( items, count );
+            while( pushed < count ) {
+                push( std::move( items[ pushed++ ] ) );
+                pushed += tryPush_n( items + pushed, count - pushed );
+            }
+        }
+
+        /**
+         * Tries, popping up to \a count items.
+         * @param [out] items Buffer for popped items.
+         * @param [in] count Capacity of buffer.
+         * @return Number of popped items.
+         */
+        [[nodiscard]] uint32_t tryPop_n( T *items, uint32_t count ) noexcept {
+            uint32_t popped = 0;
+            while( popped < count && dequeue( items[ popped ] ) )
+                popped++;
+
+            if( popped == 1 )
+                not_full.notify_one();
+            else if( popped > 1 )
+                not_full.notify_all();
+            return popped;
+        }
+
+        /**
+         * Pops at least one and up to \a count items, blocks while queue is empty.
+         * @param [out] items Buffer for popped items.
+         * @param [in] count Capacity of buffer, must not be 0.
+         * @return Number of popped items.
+         */
+        uint32_t pop_n( T *items, uint32_t count ) noexcept {
+            items[ 0 ] = pop();
+            return 1 + tryPop_n( items + 1, count - 1 );
+        }
+
+        /**
+         * Capacity of queue.
+         */
+        [[nodiscard]] uint32_t capacity() const noexcept {
+            return static_cast<uint32_t>( mask + 1 );
+        }
+
+    protected:
+        /**
+         * @brief Slot of ring on own cache line.
+         */
+        struct alignas( 64 ) Slot {
+            /**
+             * Position slot waits for; position when free, position + 1 when it holds item.
+             */
+            uint64_t sequence;
+            alignas( T ) unsigned char storage[ sizeof( T ) ];  /**< Item. */
+        };
+
+        /**
+         * Claims slot for producer and constructs item in it.
+         * @return false if queue is full.
+         */
+        template <typename Item_T>
+        bool enqueue( Item_T &&item ) noexcept {
+            uint64_t position = __atomic_load_n( &enqueue_position, __ATOMIC_RELAXED );
+            Slot *slot;
+
+            while( true ) {
+                slot = &slots[ position & mask ];
+                uint64_t sequence = __atomic_load_n( &slot->sequence, __ATOMIC_ACQUIRE );
+                auto difference = static_cast<int64_t>( sequence - position );
+
+                if( difference == 0 ) {
+                    if( __atomic_compare_exchange_n( &enqueue_position, &position, position + 1, true,
+                                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+                        break;
+                }
+                // slot still holds item of previous lap
+                else if( difference < 0 )
+                    return false;
+                else position = __atomic_load_n( &enqueue_position, __ATOMIC_RELAXED );
+            }
+
+            new( slot->storage ) T( std::forward<Item_T>( item ) );
+            __atomic_store_n( &slot->sequence, position + 1, __ATOMIC_RELEASE );
+            return true;
+        }
+
+        /**
+         * Claims slot for consumer and moves item out of it.
+         * @return false if queue is empty.
+         */
+        bool dequeue( T &item ) noexcept {
+            uint64_t position = __atomic_load_n( &dequeue_position, __ATOMIC_RELAXED );
+            Slot *slot;
+
+            while( true ) {
+                slot = &slots[ position & mask ];
+                uint64_t sequence = __atomic_load_n( &slot->sequence, __ATOMIC_ACQUIRE );
+                auto difference = static_cast<int64_t>( sequence - ( position + 1 ) );
+
+                if( difference == 0 ) {
+                    if( __atomic_compare_exchange_n( &dequeue_position, &position, position + 1, true,
+                                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+                        break;
+                }
+                // slot was not published yet
+                else if( difference < 0 )
+                    return false;
+                else position = __atomic_load_n( &dequeue_position, __ATOMIC_RELAXED );
+            }
+
+            T *stored = std::launder( reinterpret_cast<T *>( slot->storage ) );
+            item = std::move( *stored );
+            stored->~T();
+            __atomic_store_n( &slot->sequence, position + mask + 1, __ATOMIC_RELEASE );
+            return true;
+        }
+
+        /**
+         * Pushes item, parks on not_full while queue is full.
+         * @return false if deadline expired.
+         */
+        template <typename Item_T>
+        bool push_wait( Item_T &&item, const struct timespec *deadline ) noexcept {
+            while( !tryPush( std::forward<Item_T>( item ) ) ) {
+                EventCount::Key key = not_full.prepare_wait();
+                if( tryPush( std::forward<Item_T>( item ) ) ) {
+                    not_full.cancel_wait();
+                    return true;
+                }
+                if( !not_full.commit_wait( key, deadline ) )
+                    return tryPush( std::forward<Item_T>( item ) );
+            }
+            return true;
+        }
+
+        /**
+         * Pops item, parks on not_empty while queue is empty.
+         * @return false if deadline expired.
+         */
+        bool pop_wait( T &item, const struct timespec *deadline ) noexcept {
+            while( !tryPop( item ) ) {
+                EventCount::Key key = not_empty.prepare_wait();
+                if( tryPop( item ) ) {
+                    not_empty.cancel_wait();
+                    return true;
+                }
+                if( !not_empty.commit_wait( key, deadline ) )
+                    return tryPop( item );
+            }
+            return true;
+        }
+
+    private:
+        alignas( 64 ) uint64_t enqueue_position = 0;    /**< Next position of producer. */
+        alignas( 64 ) uint64_t dequeue_position = 0;    /**< Next position of consumer. */
+        alignas( 64 ) std::unique_ptr<Slot[]> slots;    /**< Ring of slots. */
+        uint64_t mask;                                  /**< Capacity - 1. */
+        EventCount not_empty;                           /**< Parked consumers. */
+        EventCount not_full;                            /**< Parked producers. */
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Counting semaphore stored in single futex word.
+     *
+     * Lower 31 bits of word are value of semaphore, highest bit is set by threads going to sleep.
+     * give is single atomic addition whose result tells if anybody sleeps, so give without
+     * waiters never issues sys-call nor reads other word. Taker sets waiter bit with the same
+     * compare-and-swap it would use for taking, there is no separate waiter counter.
+     * @par
+     * Giver which finds waiter bit set clears it and wakes all sleepers, threads that do not get
+     * unit set the bit again. This suits semaphores with few blocked threads;
+     * for many blocked threads prefer yarn::Semaphore or yarn::FairSemaphore.
+     * @note Value is limited to 2^31 - 1.
+     */
+    class CompactSemaphore {
+    public:
+        /**
+         * Constructor of CompactSemaphore.
+         * @param [in] initial_value
+         */
+        explicit CompactSemaphore( uint32_t initial_value = 0 ) noexcept;
+
+        CompactSemaphore( const CompactSemaphore & ) = delete;
+
+        CompactSemaphore &operator=( const CompactSemaphore & ) = delete;
+
+        /**
+         * Decrements semaphore. If semaphore value is 0, blocks until other thread calls give.
+         */
+        void take() noexcept;
+
+        /**
+         * Tries, decrementing semaphore.
+         * @return true if semaphore was decremented successfully.
+         */
+        [[nodiscard]] bool tryTake() noexcept;
+
+        /**
+         * Increments semaphore value.
+         */
+        void give() noexcept;
+
+        /**
+         * Increments semaphore value by \a count with single atomic addition.
+         * @param [in] count Number of units.
+         */
+        void give( uint32_t count ) noexcept;
+
+        /**
+         * Reads value of semaphore atomically.
+         * @return Snapshot of value, it may be changed by other threads right after reading.
+         */
+        [[nodiscard]] uint32_t value() const noexcept;
+
+    protected:
+        static constexpr uint32_t waiter_bit = 1u << 31;    /**< Some thread may sleep on word. */
+
+    private:
+        uint32_t word;      /**< Value of semaphore and waiter bit. */
+    };
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Event count, lets consumers of lock-free structures sleep without lost wake-ups.
+     *
+     * Consumer which found nothing to do announces itself by prepare_wait, checks its condition again
+     * and then either calls cancel_wait or commit_wait. Notification sent after prepare_wait makes
+     * commit_wait return immediately, so condition made true between check and sleep is never missed.
+     * @par
+     * State is single 64-bit word; lower half counts prepared waiters and upper half is epoch,
+     * which is also futex word of sleeping waiters. Producer with nobody waiting pays only
+     * memory fence and one load, no read-modify-write nor sys-call.
+     * @code
+     * while( !queue.try_pop( item ) ) {
+     *     auto key = event.prepare_wait();
+     *     if( queue.try_pop( item ) ) {
+     *         event.cancel_wait();
+     *         break;
+     *     }
+     *     event.commit_wait( key );
+     * }
+     * @endcode
+     */
+    class EventCount {
+    public:
+        /**
+         * Epoch observed by prepare_wait.
+         */
+        using Key = uint32_t;
+
+        EventCount() = default;
+
+        EventCount( const EventCount & ) = delete;
+
+        EventCount &operator=( const EventCount & ) = delete;
+
+        /**
+         * Announces caller as waiter, caller must check its condition afterwards.
+         * @return Key for commit_wait.
+         */
+        [[nodiscard]] Key prepare_wait() noexcept;
+
+        /**
+         * Withdraws waiter announced by prepare_wait, when condition turned out true.
+         */
+        void cancel_wait() noexcept;
+
+        /**
+         * Sleeps until notification sent after prepare_wait which returned \a key.
+         * @param [in] key Result of prepare_wait.
+         */
+        void commit_wait( Key key ) noexcept;
+
+        /**
+         * Same as EventCount::commit_wait( Key ) but sleeps at most until \a deadline.
+         * @param [in] key Result of prepare_wait.
+         * @param [in] deadline Absolute time of CLOCK_MONOTONIC, nullptr for no deadline.
+         * @return false if deadline expired before notification.
+         */
+        [[nodiscard]] bool commit_wait( Key key, const struct timespec *deadline ) noexcept;
+
+        /**
+         * Wakes up one waiter, if there is any.
+         * @note Must be called after condition of waiters was made true.
+         */
+        void notify_one() noexcept;
+
+        /**
+         * Wakes up all waiters.
+         * @note Must be called after condition of waiters was made true.
+         */
+        void notify_all() noexcept;
+
+        /**
+         * Blocks until predicate evaluates to true.
+         * @tparam Callable_T Predicate type.
+         * @param predicate Callable object, evaluated without any lock.
+         */
+        template <typename Callable_T>
+        void await( Callable_T predicate ) {
+            static_assert( std::is_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            while( !predicate() ) {
+                Key key = prepare_wait();
+                if( predicate() ) {
+                    cancel_wait();
+                    return;
+                }
+                commit_wait( key );
+            }
+        }
+
+    protected:
+        /**
+         * Wakes up \a count waiters by moving epoch.
+         */
+        void notify( uint32_t count ) noexcept;
+
+        /**
+         * Futex word, upper half of state.
+         */
+        uint32_t *epoch() noexcept;
+
+        static constexpr uint64_t waiter_inc = 1;               /**< One waiter in lower half. */
+        static constexpr uint64_t epoch_inc = uint64_t( 1 ) << 32;  /**< One epoch in upper half. */
+
+    private:
+        uint64_t state = 0;     /**< Epoch in upper half, number of waiters in lower half. */
+    };
+}
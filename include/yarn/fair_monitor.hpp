@@ -0,0 +1,117 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Monitor serving threads in strict arrival order.
+     *
+     * Threads blocked in lock and waiters whose predicates became true are served together
+     * in order in which they arrived; lock arrival is call of lock, waiter arrival is call of wait_for.
+     * Every thread blocks on its own futex word and monitor is handed over directly to it,
+     * so no thread can overtake thread that arrived earlier.
+     * @par
+     * Strict handoff costs throughput, because monitor stays owned while next thread is being scheduled.
+     * Barging window allows new threads to take free monitor while oldest blocked thread
+     * waits shorter than the window; oldest thread that waits longer is always served by handoff.
+     * This bounds waiting time of every thread while allowing barging under light contention.
+     */
+    class FairMonitor {
+    public:
+        /**
+         * Constructor of FairMonitor.
+         * @param [in] barging_window_us Time oldest blocked thread can be overtaken by new threads, 0 for strict FIFO.
+         */
+        explicit FairMonitor( uint32_t barging_window_us = 0 ) noexcept;
+
+        FairMonitor( const FairMonitor & ) = delete;
+
+        FairMonitor &operator=( const FairMonitor & ) = delete;
+
+        /**
+         * Acquires monitor, blocked threads are served in arrival order.
+         */
+        void lock() noexcept;
+
+        /**
+         * Tries to acquire monitor.
+         * @return true if monitor was acquired.
+         * @note Fails if monitor is free but reserved for thread blocked longer than barging window.
+         */
+        [[nodiscard]] bool tryLock() noexcept;
+
+        /**
+         * Suspends caller until predicate evaluates to true.
+         * Caller owns monitor again when wait_for returns.
+         * @tparam Callable_T Predicate type.
+         * @param predicate Callable object that returns true when wait should end.
+         */
+        template <typename Callable_T>
+        void wait_for( Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            if( predicate() )
+                return;
+
+            PredicateRef reference( predicate );
+            Node node{};
+            node.predicate = &reference;
+            wait( node );
+        }
+
+        /**
+         * Hands monitor over to the oldest of: thread blocked in lock, waiter whose predicate is true.
+         * If there is no such thread monitor is released.
+         */
+        void unlock() noexcept;
+
+    protected:
+        /**
+         * @brief Blocked thread, lives in its stack frame.
+         */
+        struct Node {
+            const PredicateRef *predicate = nullptr;  /**< Predicate of waiter, nullptr for thread blocked in lock. */
+            Node *prev = nullptr;                     /**< Previous node in queue. */
+            Node *next = nullptr;                     /**< Next node in queue. */
+            uint64_t arrival_us = 0;                  /**< Time of arrival, used by barging window. */
+            uint32_t ticket = 0;                      /**< Arrival order. */
+
+            /**
+             * State of thread; 0- thread should wait, 1- monitor was handed over to thread,
+             * 2- monitor was released, thread should try to acquire it.
+             */
+            uint32_t state = 0;
+        };
+
+        /**
+         * Blocks owner of monitor as waiter until its predicate is true and monitor is handed over.
+         */
+        void wait( Node &node ) noexcept;
+
+        /**
+         * Checks if new thread can take free monitor, must be called with queue_lock.
+         */
+        bool may_barge() const noexcept;
+
+        /**
+         * Appends node to the end of queue.
+         */
+        static void push( Node *&head, Node *&tail, Node &node ) noexcept;
+
+        /**
+         * Removes node from queue.
+         */
+        static void erase( Node *&head, Node *&tail, Node &node ) noexcept;
+
+    private:
+        Lock queue_lock;                 /**< Protects owned flag and entry queue. */
+        bool owned = false;              /**< Monitor is owned by some thread. */
+        Node *entry_head = nullptr;      /**< Oldest thread blocked in lock. */
+        Node *entry_tail = nullptr;      /**< Newest thread blocked in lock. */
+        Node *waiter_head = nullptr;     /**< Oldest waiter, list is modified only by owner. */
+        Node *waiter_tail = nullptr;     /**< Newest waiter. */
+        uint32_t next_ticket = 0;        /**< Ticket of next arriving thread. */
+        uint32_t barging_window;         /**< Time in us oldest blocked thread can be overtaken. */
+    };
+}
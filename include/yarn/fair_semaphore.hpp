@@ -0,0 +1,88 @@
+#pragma once
+#include "primitives.hpp"
+#include "weighted_waiters.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Semaphore serving takers in strict arrival order.
+     *
+     * Every blocked taker waits on its own futex word in FIFO queue and give hands units
+     * directly to the oldest takers, so a thread calling tryTake can never steal units
+     * from a thread that blocked earlier.
+     * @par
+     * Takers may request more units at once. Queue is strictly FIFO for weighted requests as well:
+     * while the oldest taker cannot be satisfied, younger takers wait even if their smaller requests
+     * would fit, so large requests can not be starved. When the oldest taker times out or is cancelled,
+     * units it was blocking are handed to following takers immediately.
+     */
+    class FairSemaphore {
+    public:
+        /**
+         * Constructor of FairSemaphore.
+         * @param [in] initial_value Initial number of units.
+         */
+        explicit FairSemaphore( uint32_t initial_value = 0 ) noexcept;
+
+        FairSemaphore( const FairSemaphore & ) = delete;
+
+        FairSemaphore &operator=( const FairSemaphore & ) = delete;
+
+        /**
+         * Takes one unit, blocks behind every taker that arrived earlier.
+         */
+        void take() noexcept;
+
+        /**
+         * Takes \a count units at once, blocks behind every taker that arrived earlier.
+         * @param [in] count Number of units.
+         */
+        void take_n( uint32_t count ) noexcept;
+
+        /**
+         * Same as FairSemaphore::take_n( uint32_t ) but if units are not handed over before deadline,
+         * exception is raised and taker leaves queue with nothing taken.
+         * @param [in] count Number of units.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @throws yarn::TimeoutExpiredException
+         */
+        void take_until( uint32_t count, std::chrono::steady_clock::time_point deadline );
+
+        /**
+         * Same as FairSemaphore::take_n( uint32_t ) but wait ends when stop is requested on \a token.
+         * @param [in] count Number of units.
+         * @param [in] token Stop token cancelling the wait.
+         * @return true if units were taken, false if wait was cancelled and nothing was taken.
+         */
+        [[nodiscard]] bool take_n( uint32_t count, std::stop_token token ) noexcept;
+
+        /**
+         * Tries, taking one unit immediately.
+         * @return true if unit was taken successfully.
+         * @note Fails if any taker is blocked, even if units are available.
+         */
+        [[nodiscard]] bool tryTake() noexcept;
+
+        /**
+         * Tries, taking \a count units immediately, all or nothing.
+         * @param [in] count Number of units.
+         * @return true if units were taken successfully.
+         * @note Fails if any taker is blocked, even if units are available.
+         */
+        [[nodiscard]] bool tryTake( uint32_t count ) noexcept;
+
+        /**
+         * Gives one unit, hands it over to oldest taker if it can be satisfied.
+         */
+        void give() noexcept;
+
+        /**
+         * Gives \a count units, hands them over to oldest takers as long as they can be satisfied.
+         * @param [in] count Number of units.
+         */
+        void give( uint32_t count ) noexcept;
+
+    private:
+        WeightedWaiters waiters;    /**< Available units and blocked takers in arrival order. */
+    };
+}
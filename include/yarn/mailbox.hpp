@@ -0,0 +1,183 @@
+#pragma once
+#include "primitives.hpp"
+
+#include <cerrno>
+#include <sched.h>
+
+
+namespace yarn {
+    /**
+     * @brief Link embedded in message of Mailbox.
+     *
+     * Message type derives from MailboxNode, so pushing message allocates nothing.
+     * Message may be in at most one mailbox at a time.
+     */
+    struct MailboxNode {
+        MailboxNode *next = nullptr;    /**< Next newer message. */
+    };
+
+
+    /**
+     * @brief Intrusive multi-producer single-consumer queue for actor mailboxes.
+     *
+     * Node based queue of Dmitry Vyukov; producer links message by single atomic exchange and
+     * single store, so push is wait-free and never allocates. Only one thread may pop.
+     * @par
+     * Consumer parks on futex word when mailbox is empty. Producer wakes it only when its message made
+     * mailbox non-empty, producers pushing into non-empty mailbox issue no sys-call and no read of
+     * consumer's word.
+     * @tparam T Message type, must derive from MailboxNode.
+     * @warning Messages are owned by caller; message must stay alive until it is popped.
+     */
+    template <typename T>
+    class Mailbox {
+        static_assert( std::is_base_of_v<MailboxNode, T>, "Message must derive from MailboxNode." );
+
+    public:
+        Mailbox() = default;
+
+        Mailbox( const Mailbox & ) = delete;
+
+        Mailbox &operator=( const Mailbox & ) = delete;
+
+        /**
+         * Pushes message, wakes consumer if mailbox was empty.
+         * @param [in] message Pushed message.
+         */
+        void push( T &message ) noexcept {
+            if( link( &message ) != &stub )
+                return;
+
+            // mailbox was empty, consumer may be parked
+            if( __atomic_exchange_n( &parked, 0, __ATOMIC_ACQ_REL ) == 1 )
+                _simple_futex( &parked, FUTEX_WAKE, 1 );
+        }
+
+        /**
+         * Tries, popping oldest message.
+         * @return Message or nullptr if mailbox is empty or producer has not finished linking yet.
+         * @note Must be called by consumer only.
+         */
+        [[nodiscard]] T *tryPop() noexcept {
+            MailboxNode *message = nullptr;
+            (void) take( message );
+            return static_cast<T *>( message );
+        }
+
+        /**
+         * Pops oldest message, parks while mailbox is empty.
+         * @return Message.
+         * @note Must be called by consumer only.
+         */
+        T *pop() noexcept {
+            return static_cast<T *>( wait( nullptr ) );
+        }
+
+        /**
+         * Same as Mailbox::pop but if mailbox stays empty until deadline, exception is raised.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @return Message.
+         * @throws yarn::TimeoutExpiredException
+         * @note Must be called by consumer only.
+         */
+        T *pop_until( std::chrono::steady_clock::time_point deadline ) {
+            const struct timespec abs_deadline = _to_timespec( deadline );
+            MailboxNode *message = wait( &abs_deadline );
+            if( message == nullptr )
+                throw TimeoutExpiredException( "Timeout expired before message arrived." );
+            return static_cast<T *>( message );
+        }
+
+    protected:
+        /**
+         * Links node after newest node.
+         * @return Previous newest node.
+         */
+        MailboxNode *link( MailboxNode *node ) noexcept {
+            __atomic_store_n( &node->next, nullptr, __ATOMIC_RELAXED );
+            MailboxNode *previous = __atomic_exchange_n( &head, node, __ATOMIC_ACQ_REL );
+            __atomic_store_n( &previous->next, node, __ATOMIC_RELEASE );
+            return previous;
+        }
+
+        /**
+         * Takes oldest message.
+         * @param [out] message Taken message, nullptr if none was taken.
+         * @return false if mailbox is empty, true if message was taken or producer is in the middle of push.
+         */
+        bool take( MailboxNode *&message ) noexcept {
+            message = nullptr;
+            MailboxNode *oldest = tail;
+            MailboxNode *next = __atomic_load_n( &oldest->next, __ATOMIC_ACQUIRE );
+
+            if( oldest == &stub ) {
+                if( next == nullptr )
+                    return __atomic_load_n( &head, __ATOMIC_ACQUIRE ) != &stub;
+                tail = next;
+                oldest = next;
+                next = __atomic_load_n( &next->next, __ATOMIC_ACQUIRE );
+            }
+
+            if( next != nullptr ) {
+                tail = next;
+                message = oldest;
+                return true;
+            }
+
+            // producer exchanged head but did not link its node yet
+            if( oldest != __atomic_load_n( &head, __ATOMIC_ACQUIRE ) )
+                return true;
+
+            // oldest is the last node, stub is linked after it so oldest can be returned
+            link( &stub );
+            next = __atomic_load_n( &oldest->next, __ATOMIC_ACQUIRE );
+            if( next == nullptr )
+                return true;
+
+            tail = next;
+            message = oldest;
+            return true;
+        }
+
+        /**
+         * Takes message, parks while mailbox is empty.
+         * @return Message or nullptr if deadline expired.
+         */
+        MailboxNode *wait( const struct timespec *deadline ) noexcept {
+            while( true ) {
+                MailboxNode *message = nullptr;
+                if( take( message ) ) {
+                    if( message != nullptr )
+                        return message;
+                    // producer finishes push in few instructions
+                    sched_yield();
+                    continue;
+                }
+
+                // announce parking before last check, producer either sees us or we see its message
+                __atomic_store_n( &parked, 1, __ATOMIC_RELAXED );
+                __sync_synchronize();
+
+                if( take( message ) ) {
+                    __atomic_store_n( &parked, 0, __ATOMIC_RELAXED );
+                    if( message != nullptr )
+                        return message;
+                    continue;
+                }
+
+                bool expired = _deadline_futex( &parked, 1, deadline ) == -1 && errno == ETIMEDOUT;
+                __atomic_store_n( &parked, 0, __ATOMIC_RELAXED );
+                if( expired ) {
+                    take( message );
+                    return message;
+                }
+            }
+        }
+
+    private:
+        MailboxNode *head = &stub;      /**< Newest node, exchanged by producers. */
+        alignas( 64 ) MailboxNode *tail = &stub;    /**< Oldest node, owned by consumer. */
+        MailboxNode stub;               /**< Placeholder keeping queue non-empty. */
+        uint32_t parked = 0;            /**< Futex word, 1 while consumer is parked. */
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Global table of queues of parked threads keyed by address.
+     *
+     * Thread parks on any address, not only on futex word, so synchronisation primitive needs no space
+     * for its waiters; it only keeps bit telling that somebody may be parked on its address.
+     * Queues live in fixed number of buckets selected by hash of address, every parked thread waits
+     * on futex word in its own stack frame.
+     * @par
+     * Validation of park and callback of unpark run with lock of bucket, so primitive can atomically
+     * decide to sleep and clear its parked bit when last thread is unparked.
+     * Unparker can hand token to unparked thread, for example to tell it that lock was handed over.
+     */
+    class ParkingLot {
+    public:
+        /**
+         * @brief Outcome of unpark passed to unpark callback.
+         */
+        struct UnparkResult {
+            bool unparked = false;      /**< Some thread was unparked. */
+            bool have_more = false;     /**< Other threads are still parked on the same address. */
+        };
+
+        /**
+         * Parks caller on \a address if \a validate returns true.
+         * @tparam Callable_T Predicate type.
+         * @param [in] address Key of queue.
+         * @param [in] validate Predicate evaluated with lock of queue, parking is aborted when it returns false.
+         * @param [in] deadline Absolute time of CLOCK_MONOTONIC, nullptr for no deadline.
+         * @param [out] token Token given by unparker, if not nullptr.
+         * @return true if caller was unparked, false if validation failed or deadline expired.
+         */
+        template <typename Callable_T>
+        static bool park( const void *address, Callable_T validate,
+                          const struct timespec *deadline = nullptr, intptr_t *token = nullptr ) noexcept {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Validation must be callable with return type bool." );
+
+            PredicateRef reference( validate );
+            return park_conditionally( address, reference, deadline, token );
+        }
+
+        /**
+         * Unparks oldest thread parked on \a address.
+         * @tparam Callable_T Callback type.
+         * @param [in] address Key of queue.
+         * @param [in] callback Called with lock of queue and UnparkResult, even if no thread was parked;
+         * returns token handed to unparked thread.
+         * @return Outcome of unpark.
+         */
+        template <typename Callable_T>
+        static UnparkResult unpark_one( const void *address, Callable_T callback ) noexcept {
+            static_assert( std::is_nothrow_invocable_r_v<intptr_t, Callable_T, UnparkResult>,
+                    "Callback must be callable with UnparkResult and return token." );
+
+            return unpark_one_with( address, &callback, []( void *object, UnparkResult result ) noexcept -> intptr_t {
+                return ( *static_cast<Callable_T *>( object ) )( result );
+            } );
+        }
+
+        /**
+         * Unparks all threads parked on \a address.
+         * @param [in] address Key of queue.
+         * @param [in] token Token handed to every unparked thread.
+         * @return Number of unparked threads.
+         */
+        static uint32_t unpark_all( const void *address, intptr_t token = 0 ) noexcept;
+
+    protected:
+        /**
+         * Type-erased implementation of park.
+         */
+        static bool park_conditionally( const void *address, const PredicateRef &validate,
+                                        const struct timespec *deadline, intptr_t *token ) noexcept;
+
+        /**
+         * Type-erased implementation of unpark_one.
+         */
+        static UnparkResult unpark_one_with( const void *address, void *object,
+                                             intptr_t ( *callback )( void *, UnparkResult ) noexcept ) noexcept;
+    };
+
+
+    /**
+     * @brief Lock occupying single byte, slow path parks in ParkingLot.
+     *
+     * Lock uses two bits; locked bit and parked bit telling that some thread may be parked on address of lock.
+     * Unlock without parked threads is single compare-and-swap. Unparked thread competes for lock
+     * with new threads, so lock favours throughput over fairness.
+     */
+    class ByteLock {
+    public:
+        ByteLock() = default;
+
+        ByteLock( const ByteLock & ) = delete;
+
+        ByteLock &operator=( const ByteLock & ) = delete;
+
+        /**
+         * Acquires lock, blocks until lock is released.
+         */
+        void lock() noexcept;
+
+        /**
+         * Tries, acquiring lock.
+         * @return true if lock was acquired.
+         */
+        [[nodiscard]] bool tryLock() noexcept;
+
+        /**
+         * Releases lock and unparks one thread if some is parked.
+         */
+        void unlock() noexcept;
+
+    protected:
+        /**
+         * Spins and parks until lock is acquired.
+         */
+        void lock_slow() noexcept;
+
+        /**
+         * Releases lock with parked bit set.
+         */
+        void unlock_slow() noexcept;
+
+        static constexpr uint8_t locked = 1;    /**< Lock is owned. */
+        static constexpr uint8_t parked = 2;    /**< Some thread may be parked on address of lock. */
+        static constexpr uint32_t spin_count = 40;  /**< Attempts before parking. */
+
+    private:
+        uint8_t bits = 0;   /**< Locked and parked bits. */
+    };
+}
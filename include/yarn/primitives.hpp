@@ -2,17 +2,20 @@
 #include <cstdint>
 #include <string>
 #include <type_traits>
-#include <list>
 #include <linux/futex.h>
-#include <functional>
+#include <chrono>
+#include <stop_token>
+#include <climits>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 
 /**
  * @brief Library namespace.
  *
  * Contains synchronisation primitives similar to pthread.
- * @todo Implement monitor, fairLock, fairSemaphore, fairMonitor.
- * @todo Implement threadPool
+ * @todo Implement fairLock.
  */
 namespace yarn {
     /**
@@ -27,7 +30,111 @@ namespace yarn {
     _simple_futex( const uint32_t *uaddr,
                    int futex_op,
                    uint32_t val,
-                   const struct timespec *timeout = nullptr );
+                   const struct timespec *timeout = nullptr ) {
+        return syscall( SYS_futex, uaddr, futex_op, val, timeout, nullptr, 0 );
+    }
+
+    /**
+     * Wrapper for FUTEX_CMP_REQUEUE sys-call.
+     * @param uaddr Address of futex word waiters are blocked on.
+     * @param wake_count Maximum number of waiters woken up.
+     * @param requeue_count Maximum number of remaining waiters moved to \a uaddr2.
+     * @param uaddr2 Address of futex word waiters are moved to.
+     * @param expected Value \a uaddr must hold, otherwise call fails with EAGAIN.
+     * @return Number of woken and requeued waiters, -1 on failure.
+     */
+    inline long
+    _requeue_futex( const uint32_t *uaddr,
+                    uint32_t wake_count,
+                    uint32_t requeue_count,
+                    const uint32_t *uaddr2,
+                    uint32_t expected ) {
+        return syscall( SYS_futex, uaddr, FUTEX_CMP_REQUEUE, wake_count,
+                        reinterpret_cast<const struct timespec *>( static_cast<uintptr_t>( requeue_count ) ),
+                        uaddr2, expected );
+    }
+
+    /**
+     * Wrapper for FUTEX_WAKE_OP sys-call.
+     * Atomically applies \a op on \a uaddr2, wakes waiters on \a uaddr
+     * and if comparison encoded in \a op holds for old value of \a uaddr2, wakes waiters on \a uaddr2.
+     * @param uaddr Address of first futex word.
+     * @param wake_count Maximum number of waiters woken up on \a uaddr.
+     * @param wake_count2 Maximum number of waiters woken up on \a uaddr2.
+     * @param uaddr2 Address of second futex word, modified by operation.
+     * @param op Operation and comparison encoded by FUTEX_OP macro.
+     * @return Number of woken up waiters, -1 on failure.
+     */
+    inline long
+    _wake_op_futex( const uint32_t *uaddr,
+                    uint32_t wake_count,
+                    uint32_t wake_count2,
+                    uint32_t *uaddr2,
+                    uint32_t op ) {
+        return syscall( SYS_futex, uaddr, FUTEX_WAKE_OP, wake_count,
+                        reinterpret_cast<const struct timespec *>( static_cast<uintptr_t>( wake_count2 ) ),
+                        uaddr2, op );
+    }
+
+    /**
+     * Wrapper for FUTEX_WAIT_BITSET sys-call with absolute timeout.
+     * @param uaddr Address of futex word.
+     * @param val Expected value of futex word.
+     * @param deadline Absolute CLOCK_MONOTONIC time of wake-up, nullptr blocks without timeout.
+     * @param mask Bitset of waiter, only wake-ups with intersecting mask wake it up.
+     * @return Status of call.
+     */
+    inline long
+    _deadline_futex( const uint32_t *uaddr,
+                     uint32_t val,
+                     const struct timespec *deadline,
+                     uint32_t mask = FUTEX_BITSET_MATCH_ANY ) {
+        return syscall( SYS_futex, uaddr, FUTEX_WAIT_BITSET, val, deadline, nullptr, mask );
+    }
+
+    /**
+     * Wrapper for FUTEX_WAKE_BITSET sys-call.
+     * @param uaddr Address of futex word.
+     * @param wake_count Maximum number of waiters woken up.
+     * @param mask Only waiters whose bitset intersects \a mask are woken up.
+     * @return Number of woken up waiters, -1 on failure.
+     */
+    inline long
+    _wake_bitset_futex( const uint32_t *uaddr,
+                        uint32_t wake_count,
+                        uint32_t mask ) {
+        return syscall( SYS_futex, uaddr, FUTEX_WAKE_BITSET, wake_count, nullptr, nullptr, mask );
+    }
+
+    /**
+     * Converts steady clock time point to timespec usable by futex deadline wait.
+     * @param deadline Time point of std::chrono::steady_clock (CLOCK_MONOTONIC).
+     * @return Absolute timespec, time points before clock epoch are clamped to zero.
+     */
+    inline struct timespec
+    _to_timespec( std::chrono::steady_clock::time_point deadline ) noexcept {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>( deadline.time_since_epoch() ).count();
+        if( ns < 0 )
+            ns = 0;
+        return { static_cast<time_t>( ns / 1000000000 ), static_cast<long>( ns % 1000000000 ) };
+    }
+
+    /**
+     * Rounds capacity of ring buffer up to power of 2, at least 2.
+     * @param capacity Minimal capacity.
+     * @return Rounded capacity.
+     * @throws std::invalid_argument if \a capacity is greater than 2^31, rounded capacity would not fit into 32 bits.
+     */
+    inline uint32_t
+    _ring_capacity( uint32_t capacity ) {
+        if( capacity > 1u << 31 )
+            throw std::invalid_argument( "Capacity must not be greater than 2^31." );
+
+        uint32_t size = 2;
+        while( size < capacity )
+            size *= 2;
+        return size;
+    }
 
 
     /**
@@ -72,7 +179,8 @@ namespace yarn {
          * Constructor of lock.
          * @param [in] spinlock_time_us Time lock tries to lock in spin before yielding CPU.
          */
-        explicit Lock( uint32_t spinlock_time_us = 4 ) noexcept;
+        constexpr explicit Lock( uint32_t spinlock_time_us = 4 ) noexcept
+            : spin_time( spinlock_time_us ) {}
 
         Lock( const Lock & ) = delete;
 
@@ -104,14 +212,22 @@ namespace yarn {
          */
         void unlock() noexcept;
     protected:
-        uint32_t lock_value = 0;   /**< Lock state, 1: locked, 0: unlocked. */
-        uint32_t waiter_count = 0; /**< Number of waiters is recorded to prevent unnecessary futex sys-calls. */
+        friend class Condition;
+
+        /**
+         * Acquires lock and leaves it marked as contended, so next unlock wakes up one blocked thread.
+         * @note Used by every thread that was blocked on lock value, including waiters requeued
+         * by Condition::signal_all(), so each of them passes wake-up to the next one.
+         */
+        void lock_contended() noexcept;
+
+        uint32_t lock_value = 0;   /**< Lock state, 0: unlocked, 1: locked, 2: locked and some thread may be blocked. */
         uint32_t spin_time;        /**< Time in ns, lock spins before yielding CPU. */
     };
 
 
     /**
-     * @brief Simple counting unbounded semaphore with public value.
+     * @brief Simple counting unbounded semaphore.
      *
      * Semaphore is counting mechanism used for thread synchronisation.
      * In simple terms semaphore is unsigned integral value with increment(\a give) and decrement(\a take) operations.
@@ -152,18 +268,50 @@ namespace yarn {
          */
         [[nodiscard]] bool tryTake() noexcept;
 
+        /**
+         * Decrements semaphore by \a count at once. If value is lower than \a count, blocks until
+         * other threads give enough; units are never taken partially, so waiting thread holds nothing.
+         * @param [in] count Number of units.
+         */
+        void take_n( uint32_t count ) noexcept;
+
+        /**
+         * Same as Semaphore::take_n( uint32_t ) but if take does not succeed after timeout, exception is raised.
+         * @param [in] count Number of units.
+         * @param [in] timeout_ns
+         * @throws yarn::TimeoutExpiredException
+         */
+        void take_n( uint32_t count, uint32_t timeout_ns );
+
+        /**
+         * Tries, taking \a count units immediately, all or nothing.
+         * @param [in] count Number of units.
+         * @return true if units were taken successfully.
+         */
+        [[nodiscard]] bool tryTake( uint32_t count ) noexcept;
+
         /**
          * Increments semaphore value.
          */
         void give() noexcept;
 
         /**
-         * Value of semaphore.
-         * @warning Be careful when accessing this value to avoid races.
+         * Increments semaphore value by \a count with single atomic addition,
+         * and wakes up at most \a count waiters with single sys-call.
+         * @param [in] count Number of units.
+         */
+        void give( uint32_t count ) noexcept;
+
+        /**
+         * Reads value of semaphore atomically.
+         * @return Snapshot of value, it may be changed by other threads right after reading.
          */
-        uint32_t value;
+        [[nodiscard]] uint32_t value() const noexcept;
+
     protected:
+        uint32_t units;             /**< Value of semaphore. */
         uint32_t waiter_count = 0;  /**< Number of waiters to prevent unnecessary futex sys-calls */
+        uint32_t batch_waiters = 0; /**< Number of waiters taking more than one unit, they need all waiters woken. */
         uint32_t spin_time;         /**< Time in ns spent in spin-loop before yielding CPU. */
     };
 
@@ -173,6 +321,15 @@ namespace yarn {
      * @note Use note, when checking or setting control variables that controls wake up of threads or signaling,
      * lock must be acquired to prevent race conditions.
      * @note Single lock can be used with multiple Conditions (to minimise unnecessary wake-ups).
+     * @par
+     * Waiters block on sequence word which is bumped by every signal, so signal sent between
+     * releasing lock and blocking is never lost. Every signal sent while some waiter is pending lets
+     * at most one pending waiter proceed, and signal is not lost if some of them times out meanwhile;
+     * waiters woken up without granted wake-up block again without touching the lock.
+     * Signals sent when nobody waits are free.
+     * @par
+     * Waiters can also be divided into up to 32 classes by bitmask. Class waiters block on separate futex word
+     * with FUTEX_WAIT_BITSET, and class signals wake only waiters whose mask intersects signal mask.
      */
     class Condition {
     public:
@@ -185,22 +342,171 @@ namespace yarn {
         /**
          * Releases lock, and waits for signal or signal_all call.
          * Lock is again acquired after return from wait.
-         * @warning Implementation of wait, can cause spurious wake-ups,
-         * so it is vital to re-check the condition after wake.
+         * @note Every return is caused by signal, but state can be changed by other thread
+         * before lock is reacquired, so condition should still be re-checked.
          */
         void wait( Lock &lock ) noexcept;
 
+        /**
+         * Waits until predicate evaluates to true.
+         * @tparam Callable_T Predicate type.
+         * @param [in] lock Acquired lock protecting state checked by predicate.
+         * @param [in] predicate Callable object evaluated with lock acquired.
+         */
+        template <typename Callable_T>
+            requires std::is_invocable_r_v<bool, Callable_T>
+        void wait( Lock &lock, Callable_T predicate ) {
+            while( !predicate() )
+                wait( lock );
+        }
+
+        /**
+         * Releases lock, and waits for class signal whose mask intersects \a mask.
+         * Lock is again acquired after return from wait.
+         * @param [in] lock Acquired lock.
+         * @param [in] mask Classes of waiter, must not be 0.
+         * @warning Class signal of any class sent while thread is between releasing lock and blocking
+         * makes wait return, so condition must be re-checked after wake.
+         */
+        void wait( Lock &lock, uint32_t mask ) noexcept;
+
+        /**
+         * Waits for class signals until predicate evaluates to true.
+         * @tparam Callable_T Predicate type.
+         * @param [in] lock Acquired lock protecting state checked by predicate.
+         * @param [in] mask Classes of waiter, must not be 0.
+         * @param [in] predicate Callable object evaluated with lock acquired.
+         */
+        template <typename Callable_T>
+        void wait( Lock &lock, uint32_t mask, Callable_T predicate ) {
+            while( !predicate() )
+                wait( lock, mask );
+        }
+
+        /**
+         * Same as Condition::wait(Lock &) but if no signal arrives before deadline, exception is raised.
+         * Lock is acquired in either case.
+         * @param [in] lock Acquired lock.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @throws yarn::TimeoutExpiredException
+         */
+        void wait_until( Lock &lock, std::chrono::steady_clock::time_point deadline );
+
+        /**
+         * Waits until predicate evaluates to true or deadline expires.
+         * @tparam Callable_T Predicate type.
+         * @param [in] lock Acquired lock protecting state checked by predicate.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @param [in] predicate Callable object evaluated with lock acquired.
+         * @throws yarn::TimeoutExpiredException if predicate is still false after deadline.
+         */
+        template <typename Callable_T>
+        void wait_until( Lock &lock, std::chrono::steady_clock::time_point deadline, Callable_T predicate ) {
+            const struct timespec abs_deadline = _to_timespec( deadline );
+            while( !predicate() ) {
+                if( !timed_wait( lock, &abs_deadline ) && !predicate() )
+                    throw TimeoutExpiredException( "Timeout expired before condition was signaled." );
+            }
+        }
+
         /**
          * Wakes up exactly one thread.
+         * @note No sys-call is made if there are no waiters.
          */
         void signal() noexcept;
 
         /**
          * Wakes up all waiting threads.
+         * @note Only one thread is woken up, others are requeued directly to the futex of lock passed to wait,
+         * so they are woken up one by one as lock gets released instead of fighting over it all at once.
+         * @note No sys-call is made if there are no waiters.
+         * @warning All threads waiting at the same time must use same lock.
          */
         void signal_all() noexcept;
+
+        /**
+         * Wakes up one class waiter whose mask intersects \a mask, by FUTEX_WAKE_BITSET.
+         * @param [in] mask Classes to signal.
+         * @note Waiters of wait without mask are not woken up by class signals and vice versa.
+         * @note No sys-call is made if there are no class waiters.
+         */
+        void signal( uint32_t mask ) noexcept;
+
+        /**
+         * Wakes up all class waiters whose mask intersects \a mask.
+         * @param [in] mask Classes to signal.
+         * @note No sys-call is made if there are no class waiters.
+         */
+        void signal_all( uint32_t mask ) noexcept;
+
+        /**
+         * Releases lock and wakes up one waiting thread.
+         * Lock release, wake-up of signaled waiter and wake-up of thread blocked on lock
+         * are done in single FUTEX_WAKE_OP sys-call.
+         * @param [in] lock Acquired lock, used by waiters of this condition.
+         * @note Prefer over signal() followed by unlock(), signaled thread does not wake up into still held lock.
+         */
+        void signal_and_unlock( Lock &lock ) noexcept;
     protected:
-        uint32_t waiters = 0;  /**< Number of waiters on this condition. */
+        /**
+         * Common implementation of waits.
+         * @param [in] lock Acquired lock.
+         * @param [in] deadline Absolute CLOCK_MONOTONIC deadline, nullptr for no timeout.
+         * @return false if deadline expired before signal.
+         */
+        bool timed_wait( Lock &lock, const struct timespec *deadline ) noexcept;
+
+        /**
+         * Consumes one granted wake-up.
+         * @return true if there was wake-up to consume.
+         */
+        bool consume_signal() noexcept;
+
+        /**
+         * Removes timed out waiter; consumes granted wake-up if there is one, otherwise removes
+         * one not yet signaled waiter. Both happen in single compare-and-swap, so no signal is lost.
+         * @return true if wake-up was consumed.
+         */
+        bool withdraw() noexcept;
+
+        uint32_t sequence = 0;               /**< Futex word, incremented by every signal. */
+        uint32_t class_sequence = 0;         /**< Futex word of class waiters, incremented by every class signal. */
+        uint32_t class_waiters = 0;          /**< Number of class waiters. */
+        uint64_t waiter_state = 0;           /**< Low half: not yet signaled waiters, high half: granted wake-ups. */
+        Lock *associated_lock = nullptr;     /**< Lock used by waiters, target of requeue in signal_all. */
+    };
+
+
+    /**
+     * @brief Non-owning type-erased reference to predicate.
+     *
+     * Referenced predicate must outlive the reference, which holds for predicates
+     * living in stack frame of waiting thread.
+     */
+    class PredicateRef {
+    public:
+        /**
+         * Creates reference to callable object.
+         * @tparam Callable_T Predicate type.
+         * @param [in] predicate Referenced predicate.
+         */
+        template <typename Callable_T>
+        explicit PredicateRef( Callable_T &predicate ) noexcept
+            : object( &predicate ),
+              call( []( void *object ) noexcept -> bool {
+                  return ( *static_cast<Callable_T *>( object ) )();
+              } ) {}
+
+        /**
+         * Evaluates referenced predicate.
+         */
+        bool operator()() const noexcept {
+            return call( object );
+        }
+
+    private:
+        void *object;                        /**< Referenced predicate. */
+        bool ( *call )( void * ) noexcept;   /**< Invokes predicate of concrete type. */
     };
 
 
@@ -208,9 +514,15 @@ namespace yarn {
      * @brief Implementation of monitor similar to pythons monitor.
      *
      * Similar to condition variable used but checking of control conditions happens inside Monitor automatically.
+     * @par
+     * State guarded by monitor can be declared as Monitor::Cell. Monitor records which cells each predicate
+     * read during its last evaluation, and predicate reading only cells is reevaluated only after
+     * some of those cells was written.
      */
     class Monitor {
     public:
+        class CellBase;
+
         Monitor() = default;
 
         Monitor( const Monitor & ) = delete;
@@ -229,7 +541,9 @@ namespace yarn {
 
         /**
          * Suspends caller until predicate evaluates to true.
-         * All predicates are checked and if any evaluates to true
+         * If predicate is false, monitor is handed over to waiter whose predicate is true
+         * or released if there is no such waiter.
+         * Caller owns monitor again when wait_for returns.
          * @tparam Callable_T Predicate type.
          * @param predicate Callable object that returns true when wait should end.
          */
@@ -238,77 +552,346 @@ namespace yarn {
             static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
                     "Predicate must be callable with return type bool." );
 
-            const auto &node = waiters.emplace_back( predicate, 0 );
-            const auto node_it = --waiters.end();
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key_buckets;
+            wait( node );
+        }
+
+        /**
+         * Suspends caller until predicate evaluates to true, predicate is evaluated only
+         * by releases of critical sections which notified \a key.
+         * @tparam Callable_T Predicate type.
+         * @param key Tag of state predicate depends on.
+         * @param predicate Callable object that returns true when wait should end.
+         */
+        template <typename Callable_T>
+        void wait_for( uint32_t key, Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
 
-            for( auto it = waiters.begin(); it != waiters.end(); ++it ) {
-                if( !it->predicate() ) {
-                    if( it == node_it )
-                        return;
-                    continue;
-                }
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key % key_buckets;
+            wait( node );
+        }
 
-                if( it == node_it )
-                    silent_unlock();
-                else {
-                    it->lock = 1;
-                    _simple_futex(&it->lock, FUTEX_WAKE, 1);
-                }
+        /**
+         * Same as Monitor::wait_for( Callable_T ) but if predicate is not satisfied before deadline,
+         * exception is raised.
+         * Caller owns monitor in either case.
+         * @tparam Callable_T Predicate type.
+         * @param deadline Point in time of std::chrono::steady_clock.
+         * @param predicate Callable object that returns true when wait should end.
+         * @throws yarn::TimeoutExpiredException
+         * @note Waiter that timed out removes itself and checks only own predicate, other waiters are not evaluated.
+         * Caller can release monitor by silent_unlock if state was not modified.
+         */
+        template <typename Callable_T>
+        void wait_until( std::chrono::steady_clock::time_point deadline, Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
 
-                _simple_futex( &node.lock, FUTEX_WAIT, 0 );
+            const struct timespec abs_deadline = _to_timespec( deadline );
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key_buckets;
+            if( !wait( node, &abs_deadline ) )
+                throw TimeoutExpiredException( "Timeout expired before predicate was satisfied." );
+        }
 
-                // we woke up, so we can erase current node
-                waiters.erase( node_it );
+        /**
+         * Same as Monitor::wait_for( Callable_T ) but wait ends when stop is requested on \a token.
+         * Caller owns monitor in either case.
+         * @tparam Callable_T Predicate type.
+         * @param token Stop token cancelling the wait.
+         * @param predicate Callable object that returns true when wait should end.
+         * @return Result of predicate; false if wait was cancelled before predicate was satisfied.
+         * @note Cancelled waiter removes itself and checks only own predicate, other waiters are not evaluated.
+         * Caller can release monitor by silent_unlock if state was not modified.
+         */
+        template <typename Callable_T>
+        bool wait_for( std::stop_token token, Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
 
-                return;
-            }
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key_buckets;
+            std::stop_callback on_stop( token, [&node]() noexcept { cancel( node ); } );
+            return wait( node );
         }
 
+        /**
+         * Marks state tagged by \a key as modified in current critical section.
+         * Waiters registered with \a key are reevaluated when monitor is released.
+         * @param key Tag of modified state.
+         * @note Must be called by owner of monitor.
+         */
+        void notify( uint32_t key ) noexcept;
+
         /**
          * Releases all waiters without checking predicates.
+         * Waiters are served one by one on each unlock, their predicates are left intact.
          */
         void signal_all() noexcept;
 
         /**
-         * Reevaluates all predicates; if some predicate is true, it will gain lock and wake up.
+         * Reevaluates predicates of waiters without key and of waiters whose key was notified in
+         * current critical section; if some predicate is true, it will gain lock and wake up.
          * If no predicate is true, lock is released.
          * @note This implementation assures that waiting threads are served before new accesses to monitor
          * in well defined order(if more waiting threads compete for lock; first will wake up thread that
          * went to sleep first).
+         * @note Waiters with key whose key was not notified are not evaluated, so release cost
+         * does not depend on number of waiters on unrelated keys.
          */
         void unlock() noexcept;
 
+        /**
+         * Same as notify( \a key ) followed by unlock().
+         * @param key Tag of state modified in critical section.
+         */
+        void unlock( uint32_t key ) noexcept;
+
         /**
          * Releases lock without evaluating predicates; no waiting thread is woken up.
          * @note This allows only new accesses to monitor to happen.
          */
         void silent_unlock() noexcept;
 
+        /**
+         * Reevaluates predicates like unlock, but instead of handing monitor over to waiter whose predicate is true,
+         * monitor is released and that waiter is woken up together with one thread blocked in lock
+         * in single FUTEX_WAKE_OP sys-call.
+         * @note Woken up waiter competes for monitor with other threads and re-checks its predicate,
+         * so monitor is not held while waiter is being scheduled.
+         */
+        void signal_and_unlock() noexcept;
+
     protected:
+        /**
+         * Maximal number of cells tracked per predicate; predicates reading more cells are evaluated as if
+         * they did not read any cell.
+         */
+        static constexpr uint32_t max_dependencies = 4;
+
+        struct LockNode;
+
+        /**
+         * @brief Edge between cell and waiter whose predicate read the cell.
+         */
+        struct Dependency {
+            CellBase *cell = nullptr;      /**< Cell read by predicate. */
+            LockNode *node = nullptr;      /**< Waiter owning this dependency. */
+            Dependency *prev = nullptr;    /**< Previous dependency of same cell. */
+            Dependency *next = nullptr;    /**< Next dependency of same cell. */
+            uint32_t version = 0;          /**< Version of cell seen by predicate. */
+        };
+
         /**
          * @brief Internal representation of waiter.
          *
-         * Representation of waiter with predicate and lock determining wake-up.
+         * Intrusive list node living in stack frame of waiting thread, waiting never allocates.
+         * List is modified only by owner of monitor.
          */
         struct LockNode {
-            LockNode( const LockNode & ) = delete;
-            LockNode &operator=( const LockNode & ) = delete;
-
             /**
              * Predicate evaluated for release.
              */
-            std::function<bool()> predicate;
+            PredicateRef predicate;
+
+            LockNode *prev = nullptr;  /**< Previous waiter in list. */
+            LockNode *next = nullptr;  /**< Next waiter in list. */
+            uint32_t bucket = 0;       /**< Index of waiter list; key_buckets for waiters without key. */
+            uint32_t ticket = 0;       /**< Arrival order among all waiters. */
+
+            Dependency dependencies[ max_dependencies ]{};  /**< Cells read by last evaluation of predicate. */
+            uint32_t dependency_count = 0;                 /**< Number of used dependencies. */
+            bool overflow = false;     /**< Predicate read more cells than can be tracked. */
+            bool tracked = false;      /**< Predicate is reevaluated only after write to its dependencies. */
+            bool stale = false;        /**< Dependency was written since last evaluation or predicate was true. */
+            bool released = false;     /**< Waiter was released by signal_all. */
+            LockNode *stale_prev = nullptr;  /**< Previous node in list of stale nodes. */
+            LockNode *stale_next = nullptr;  /**< Next node in list of stale nodes. */
 
             /**
-             * State of waiter; 0- waiter should wait, 1- waiter should be blocked.
+             * State of waiter; 0- waiter should wait, 1- monitor was handed over to waiter,
+             * 2- waiter was woken up and must acquire monitor itself,
+             * 3- wait timed out or was cancelled, waiter must acquire monitor and remove itself.
              */
-            uint32_t lock;
+            uint32_t lock = 0;
+        };
+
+        /**
+         * Blocks owner of monitor until predicate of node evaluates to true.
+         * @param [in] node Waiter node, linked for duration of wait.
+         * @param [in] deadline Absolute CLOCK_MONOTONIC deadline, nullptr for no timeout.
+         * @return false if wait timed out or was cancelled and predicate is still false.
+         */
+        bool wait( LockNode &node, const struct timespec *deadline = nullptr ) noexcept;
+
+        /**
+         * Cancels wait of node, if monitor was not handed over to it yet.
+         * @note Can be called by any thread.
+         */
+        static void cancel( LockNode &node ) noexcept;
+
+        /**
+         * Appends node to the end of its bucket, or to list of tracked waiters.
+         */
+        void link( LockNode &node ) noexcept;
+
+        /**
+         * Removes node from its list.
+         */
+        void unlink( LockNode &node ) noexcept;
+
+        /**
+         * Removes node from monitor; from its list, list of stale waiters and from dependent lists of cells.
+         */
+        void remove( LockNode &node ) noexcept;
+
+        /**
+         * Evaluates predicate of node and records cells read by predicate.
+         * Node is moved between bucket and list of tracked waiters if needed.
+         * @return Result of predicate.
+         */
+        bool evaluate( LockNode &node ) noexcept;
+
+        /**
+         * Removes all dependencies of node.
+         */
+        void release_dependencies( LockNode &node ) noexcept;
+
+        /**
+         * Adds node to list of stale waiters.
+         */
+        void mark_stale( LockNode &node ) noexcept;
+
+        /**
+         * Removes node from list of stale waiters.
+         */
+        void clear_stale( LockNode &node ) noexcept;
+
+        /**
+         * Records read of cell by currently evaluated predicate.
+         */
+        void record( CellBase &cell ) noexcept;
+
+        /**
+         * Records write of cell in current critical section.
+         */
+        void touch( CellBase &cell ) noexcept;
+
+        /**
+         * Finds oldest waiter that is not woken up and whose predicate evaluates to true,
+         * among waiters without key and waiters with notified keys. Clears notified keys.
+         * @return Found waiter or nullptr.
+         */
+        LockNode *find_ready() noexcept;
+
+        /**
+         * Finds ready waiter and moves its state from 0 to \a state by compare-and-swap.
+         * Waiter that timed out or was cancelled meanwhile is skipped and search is repeated.
+         * @param [in] state State of waiter after hand-over, 1 or 2.
+         * @return Waiter or nullptr if there is no ready waiter; monitor must be released then.
+         */
+        LockNode *hand_over( uint32_t state ) noexcept;
+
+        /**
+         * Checks if some thread owns monitor.
+         */
+        [[nodiscard]] bool owned() const noexcept {
+            return __atomic_load_n( &monitor_lock, __ATOMIC_SEQ_CST ) != 0;
+        }
+
+        /**
+         * Number of key buckets, keys are hashed to buckets by modulo.
+         */
+        static constexpr uint32_t key_buckets = 32;
+
+        /**
+         * Index of list of waiters whose predicates are tracked through cells.
+         */
+        static constexpr uint32_t tracked_list = key_buckets + 1;
+
+    public:
+        /**
+         * @brief Base of state cells guarded by monitor.
+         *
+         * Cell counts writes and knows waiters whose predicates read it during last evaluation.
+         */
+        class CellBase {
+        public:
+            CellBase( const CellBase & ) = delete;
+
+            CellBase &operator=( const CellBase & ) = delete;
+
+            /**
+             * @return Number of writes to cell.
+             */
+            [[nodiscard]] uint32_t version() const noexcept {
+                return cell_version;
+            }
+
+        protected:
+            friend class Monitor;
+
+            /**
+             * @param [in] monitor Monitor guarding the cell.
+             */
+            explicit CellBase( Monitor &monitor ) noexcept
+                : monitor( monitor ) {}
+
+            Monitor &monitor;                   /**< Monitor guarding the cell. */
+            Dependency *dependents = nullptr;   /**< Predicates that read the cell. */
+            CellBase *next_dirty = nullptr;     /**< Next cell written in current critical section. */
+            uint32_t cell_version = 0;          /**< Number of writes. */
+            bool dirty = false;                 /**< Cell was written in current critical section. */
+        };
+
+        /**
+         * @brief Value guarded by monitor, whose reads and writes are tracked.
+         *
+         * Both reads and writes must be done by owner of monitor.
+         * @tparam T Type of value.
+         */
+        template <typename T>
+        class Cell: public CellBase {
+        public:
+            /**
+             * @param [in] monitor Monitor guarding the value.
+             * @param [in] initial_value
+             */
+            explicit Cell( Monitor &monitor, T initial_value = T{} )
+                : CellBase( monitor ), value( std::move( initial_value ) ) {}
+
+            /**
+             * Reads value, read from predicate is recorded as dependency.
+             */
+            const T &get() noexcept {
+                monitor.record( *this );
+                return value;
+            }
+
+            /**
+             * Writes value; waiters whose predicates read the cell are reevaluated on unlock.
+             */
+            void set( T new_value ) {
+                value = std::move( new_value );
+                monitor.touch( *this );
+            }
+
+        private:
+            T value;   /**< Guarded value. */
         };
 
     private:
-        uint32_t monitor_lock = 0;
-        uint32_t lock_waiters = 0;
-        std::list<LockNode> waiters;
+        uint32_t monitor_lock = 0; /**< Lock state, 0: unlocked, 1: locked, 2: locked and some thread may be blocked. */
+        LockNode *heads[ key_buckets + 2 ] = {};  /**< Oldest waiter per list, then waiters without key and tracked. */
+        LockNode *tails[ key_buckets + 2 ] = {};  /**< Newest waiter per list. */
+        LockNode *stale_head = nullptr;           /**< Tracked waiters that must be reevaluated. */
+        LockNode *evaluating = nullptr;           /**< Waiter whose predicate is being evaluated. */
+        CellBase *dirty = nullptr;                /**< Cells written in current critical section. */
+        uint32_t notified = 0;                    /**< Bitmask of buckets notified in current critical section. */
+        uint32_t next_ticket = 0;                 /**< Ticket of next waiter. */
         uint32_t spin_time = 4; // us
     };
 }
@@ -0,0 +1,204 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Waiters ordered by priority, used by PriorityCondition and PriorityMonitor.
+     *
+     * Waiters are kept in FIFO bucket per priority level, non-empty levels are tracked by bitmask,
+     * so highest priority waiter is found in O(1).
+     * @par
+     * With aging enabled, waiter that stays at the head of its level for aging interval is moved one level up,
+     * so low priority waiters can not starve.
+     */
+    class PriorityWaiters {
+    public:
+        /**
+         * Number of priority levels, higher level is served first.
+         */
+        static constexpr uint32_t levels = 32;
+
+        /**
+         * @brief Waiter, lives in stack frame of waiting thread.
+         */
+        struct Node {
+            const PredicateRef *predicate = nullptr;  /**< Predicate of monitor waiter. */
+            Node *prev = nullptr;                     /**< Previous waiter of same level. */
+            Node *next = nullptr;                     /**< Next waiter of same level. */
+            uint64_t arrival_us = 0;                  /**< Time waiter entered its current level. */
+            uint32_t priority = 0;                    /**< Current level of waiter. */
+            uint32_t state = 0;                       /**< Futex word; 0- waiter should wait, 1- waiter was released. */
+        };
+
+        /**
+         * @param [in] aging_us Time after which waiter is moved one level up, 0 disables aging.
+         */
+        explicit PriorityWaiters( uint32_t aging_us = 0 ) noexcept;
+
+        /**
+         * Appends waiter to the end of its level.
+         * @param [in] node Waiter.
+         * @param [in] priority Level of waiter, clamped to highest level.
+         */
+        void push( Node &node, uint32_t priority ) noexcept;
+
+        /**
+         * Removes waiter.
+         */
+        void erase( Node &node ) noexcept;
+
+        /**
+         * Moves aged waiters one level up.
+         */
+        void age() noexcept;
+
+        /**
+         * @return Oldest waiter of highest level, nullptr if empty.
+         */
+        [[nodiscard]] Node *top() const noexcept;
+
+        /**
+         * @return Next waiter in serving order, nullptr if \a node was last.
+         */
+        [[nodiscard]] Node *next( const Node &node ) const noexcept;
+
+        /**
+         * @return true if there are no waiters.
+         */
+        [[nodiscard]] bool empty() const noexcept {
+            return non_empty == 0;
+        }
+
+    protected:
+        Node *heads[ levels ] = {};   /**< Oldest waiter per level. */
+        Node *tails[ levels ] = {};   /**< Newest waiter per level. */
+        uint32_t non_empty = 0;       /**< Bitmask of non-empty levels. */
+        uint32_t aging;               /**< Aging interval in us. */
+    };
+
+
+    /**
+     * @brief Condition waking up waiters in order of priority.
+     *
+     * Same usage as yarn::Condition, but every waiter declares priority and blocks on its own futex word,
+     * so signal wakes the highest priority waiter (oldest among equal priority) instead of one chosen by kernel.
+     * @note Signals must be sent with lock used by waiters acquired.
+     */
+    class PriorityCondition {
+    public:
+        /**
+         * @param [in] aging_us Time after which waiter is moved one priority level up, 0 disables aging.
+         */
+        explicit PriorityCondition( uint32_t aging_us = 0 ) noexcept;
+
+        PriorityCondition( const PriorityCondition & ) = delete;
+
+        PriorityCondition &operator=( const PriorityCondition & ) = delete;
+
+        /**
+         * Releases lock, and waits for signal or signal_all call.
+         * Lock is again acquired after return from wait.
+         * @param [in] lock Acquired lock.
+         * @param [in] priority Priority of waiter, higher is woken up first.
+         */
+        void wait( Lock &lock, uint32_t priority ) noexcept;
+
+        /**
+         * Waits until predicate evaluates to true.
+         * @tparam Callable_T Predicate type.
+         * @param [in] lock Acquired lock protecting state checked by predicate.
+         * @param [in] priority Priority of waiter, higher is woken up first.
+         * @param [in] predicate Callable object evaluated with lock acquired.
+         */
+        template <typename Callable_T>
+        void wait( Lock &lock, uint32_t priority, Callable_T predicate ) {
+            while( !predicate() )
+                wait( lock, priority );
+        }
+
+        /**
+         * Wakes up highest priority waiter.
+         */
+        void signal() noexcept;
+
+        /**
+         * Wakes up all waiters, in order of priority.
+         */
+        void signal_all() noexcept;
+
+    protected:
+        PriorityWaiters waiters;   /**< Waiting threads, protected by queue_lock. */
+        Lock queue_lock;           /**< Protects waiters. */
+    };
+
+
+    /**
+     * @brief Monitor serving waiters in order of priority.
+     *
+     * Same semantics as yarn::Monitor, but on release predicates are evaluated from the highest priority waiter
+     * down, so the highest priority waiter whose predicate is true is served first.
+     */
+    class PriorityMonitor {
+    public:
+        /**
+         * @param [in] aging_us Time after which waiter is moved one priority level up, 0 disables aging.
+         */
+        explicit PriorityMonitor( uint32_t aging_us = 0 ) noexcept;
+
+        PriorityMonitor( const PriorityMonitor & ) = delete;
+
+        PriorityMonitor &operator=( const PriorityMonitor & ) = delete;
+
+        /**
+         * Acquires monitors lock.
+         */
+        void lock() noexcept;
+
+        /**
+         * Tries to acquire monitors lock.
+         */
+        [[nodiscard]] bool tryLock() noexcept;
+
+        /**
+         * Suspends caller until predicate evaluates to true.
+         * Caller owns monitor again when wait_for returns.
+         * @tparam Callable_T Predicate type.
+         * @param priority Priority of waiter, higher is served first.
+         * @param predicate Callable object that returns true when wait should end.
+         */
+        template <typename Callable_T>
+        void wait_for( uint32_t priority, Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            if( predicate() )
+                return;
+
+            PredicateRef reference( predicate );
+            PriorityWaiters::Node node{};
+            node.predicate = &reference;
+            wait( node, priority );
+        }
+
+        /**
+         * Hands monitor over to the highest priority waiter whose predicate is true.
+         * If no predicate is true, lock is released.
+         */
+        void unlock() noexcept;
+
+        /**
+         * Releases lock without evaluating predicates.
+         */
+        void silent_unlock() noexcept;
+
+    protected:
+        /**
+         * Blocks owner of monitor until monitor is handed over to node.
+         */
+        void wait( PriorityWaiters::Node &node, uint32_t priority ) noexcept;
+
+        Lock entry;                /**< Lock of monitor, stays locked when monitor is handed over. */
+        PriorityWaiters waiters;   /**< Waiting threads, modified only by owner. */
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Token bucket limiting rate of operations, without refill thread and without mutex.
+     *
+     * Bucket holds at most \a burst tokens and is refilled by \a rate tokens per second.
+     * Refill is computed lazily from CLOCK_MONOTONIC on every acquire: limiter stores only
+     * time at which bucket will be full again (generic cell rate algorithm), and every acquire
+     * moves this time forward by single compare-and-swap, so threads never contend on a lock.
+     * @par
+     * Blocking acquire reserves its tokens immediately and parks on futex word until reserved
+     * tokens are refilled, so concurrent waiters are served in reservation order.
+     * Acquiring more tokens than burst is allowed for blocking acquire; caller waits until the debt is refilled.
+     */
+    class RateLimiter {
+    public:
+        /**
+         * Constructor of RateLimiter, bucket starts full.
+         * @param [in] rate Tokens refilled per second, must be positive and finite.
+         * @param [in] burst Capacity of bucket, maximum of tokens acquired without waiting.
+         * @throws std::invalid_argument if \a rate is not positive, is not finite,
+         * or refilling one token or whole burst would take more than 64-bit ns.
+         */
+        RateLimiter( double rate, uint32_t burst );
+
+        RateLimiter( const RateLimiter & ) = delete;
+
+        RateLimiter &operator=( const RateLimiter & ) = delete;
+
+        /**
+         * Acquires \a count tokens, blocks until they are refilled.
+         * @param [in] count Number of tokens.
+         */
+        void acquire( uint32_t count = 1 ) noexcept;
+
+        /**
+         * Same as RateLimiter::acquire but if tokens would not be refilled before deadline,
+         * exception is raised immediately and no token is acquired.
+         * @param [in] count Number of tokens.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @throws yarn::TimeoutExpiredException
+         */
+        void acquire_until( uint32_t count, std::chrono::steady_clock::time_point deadline );
+
+        /**
+         * Tries, acquiring \a count tokens without waiting.
+         * @param [in] count Number of tokens.
+         * @return true if tokens were acquired.
+         */
+        [[nodiscard]] bool tryAcquire( uint32_t count = 1 ) noexcept;
+
+    protected:
+        /**
+         * Reserves \a count tokens if they are refilled before \a latest.
+         * @param [in] count Number of tokens.
+         * @param [in] now Current time in ns.
+         * @param [in] latest Latest acceptable time in ns at which tokens are available.
+         * @return Time in ns at which reserved tokens are available, 0 if reservation was refused.
+         */
+        uint64_t reserve( uint32_t count, uint64_t now, uint64_t latest ) noexcept;
+
+        /**
+         * Parks caller until \a ready time in ns.
+         */
+        void park( uint64_t ready ) noexcept;
+
+    private:
+        uint64_t full_at = 0;       /**< Time in ns at which bucket is full again. */
+        uint64_t interval;          /**< Time in ns of refilling one token. */
+        uint64_t tolerance;         /**< Time in ns of refilling whole bucket. */
+        uint32_t parking = 0;       /**< Futex word waiters park on. */
+    };
+}
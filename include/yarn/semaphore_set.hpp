@@ -0,0 +1,92 @@
+#pragma once
+#include "primitives.hpp"
+
+#include <vector>
+
+
+namespace yarn {
+    /**
+     * @brief Set of counting semaphores taken atomically, similar to System V semop.
+     *
+     * Take of several semaphores either takes requested units from all of them or from none,
+     * so threads never hold units of one semaphore idle while waiting for other; taking
+     * semaphores one by one in different order can not deadlock.
+     * @par
+     * Values are protected by Lock and taker blocks on class-selective Condition;
+     * semaphore with index \a i belongs to class \a i % 32, so give wakes only takers which
+     * need some of given semaphores.
+     */
+    class SemaphoreSet {
+    public:
+        /**
+         * @brief Units requested from or given to one semaphore of set.
+         */
+        struct Operation {
+            uint32_t semaphore;     /**< Index of semaphore in set. */
+            uint32_t count;         /**< Number of units. */
+        };
+
+        /**
+         * Constructor of SemaphoreSet.
+         * @param [in] initial_values Initial value of every semaphore, size of set is size of vector.
+         */
+        explicit SemaphoreSet( std::vector<uint32_t> initial_values );
+
+        SemaphoreSet( const SemaphoreSet & ) = delete;
+
+        SemaphoreSet &operator=( const SemaphoreSet & ) = delete;
+
+        /**
+         * Takes units from all semaphores at once, blocks until every semaphore has enough units.
+         * @param [in] operations Requested units, same semaphore may appear more times.
+         * @throws std::out_of_range if some index is not in set; nothing is taken then.
+         */
+        void take( const std::vector<Operation> &operations );
+
+        /**
+         * Tries, taking units from all semaphores at once, all or nothing.
+         * @param [in] operations Requested units, same semaphore may appear more times.
+         * @return true if units were taken.
+         * @throws std::out_of_range if some index is not in set; nothing is taken then.
+         */
+        [[nodiscard]] bool tryTake( const std::vector<Operation> &operations );
+
+        /**
+         * Gives units to semaphores and wakes takers waiting for any of them.
+         * @param [in] operations Given units.
+         * @throws std::out_of_range if some index is not in set; nothing is given then.
+         */
+        void give( const std::vector<Operation> &operations );
+
+        /**
+         * Reads value of one semaphore.
+         * @param [in] semaphore Index of semaphore in set.
+         * @return Snapshot of value, it may be changed by other threads right after reading.
+         * @throws std::out_of_range if index is not in set.
+         */
+        [[nodiscard]] uint32_t value( uint32_t semaphore );
+
+    protected:
+        /**
+         * Checks that all indexes of operations are in set.
+         * @throws std::out_of_range
+         */
+        void check( const std::vector<Operation> &operations ) const;
+
+        /**
+         * Takes units if all are available, must be called with lock.
+         * @return true if units were taken.
+         */
+        bool take_locked( const std::vector<Operation> &operations ) noexcept;
+
+        /**
+         * Computes classes of semaphores used by operations.
+         */
+        static uint32_t classes( const std::vector<Operation> &operations ) noexcept;
+
+    private:
+        Lock lock;                      /**< Protects values. */
+        Condition released;             /**< Takers wait for gives of their semaphores. */
+        std::vector<uint32_t> values;   /**< Values of semaphores. */
+    };
+}
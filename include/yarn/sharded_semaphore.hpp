@@ -0,0 +1,91 @@
+#pragma once
+#include "primitives.hpp"
+
+#include <memory>
+
+
+namespace yarn {
+    /**
+     * @brief Semaphore keeping units in per-CPU shards for high rate of give and take.
+     *
+     * Units are given to and taken from shard of CPU caller is running on, so threads on different
+     * CPUs do not share cache line of single counter. When local shard is empty, taker steals half
+     * of units of other shard. Only when every shard is empty, taker blocks on one global futex word.
+     * @par
+     * Units are moved only by atomic operations, so total number of units is preserved exactly;
+     * no unit is lost or duplicated by stealing.
+     * @note Fairness is not guaranteed, units given on other CPU may be stolen by anybody.
+     */
+    class ShardedSemaphore {
+    public:
+        /**
+         * Constructor of ShardedSemaphore.
+         * @param [in] initial_value Initial number of units, spread over shards.
+         * @param [in] shard_count Number of shards, 0 for number of configured CPUs.
+         */
+        explicit ShardedSemaphore( uint32_t initial_value = 0, uint32_t shard_count = 0 );
+
+        ShardedSemaphore( const ShardedSemaphore & ) = delete;
+
+        ShardedSemaphore &operator=( const ShardedSemaphore & ) = delete;
+
+        /**
+         * Takes one unit, prefers shard of current CPU; blocks if every shard is empty.
+         */
+        void take() noexcept;
+
+        /**
+         * Tries, taking one unit from local shard or stealing it from other shards.
+         * @return true if unit was taken successfully.
+         */
+        [[nodiscard]] bool tryTake() noexcept;
+
+        /**
+         * Gives one unit to shard of current CPU.
+         */
+        void give() noexcept;
+
+        /**
+         * Gives \a count units to shard of current CPU with single atomic addition.
+         * @param [in] count Number of units.
+         */
+        void give( uint32_t count ) noexcept;
+
+        /**
+         * Sums units of all shards.
+         * @return Number of units.
+         * @note Result is exact only if no other thread gives or takes concurrently.
+         */
+        [[nodiscard]] uint32_t available() const noexcept;
+
+    protected:
+        /**
+         * @brief Units of one CPU, padded to own cache line.
+         */
+        struct alignas( 64 ) Shard {
+            uint32_t value = 0;     /**< Units in shard. */
+        };
+
+        /**
+         * Finds shard of CPU caller is running on.
+         */
+        Shard &local() noexcept;
+
+        /**
+         * Takes half of units of other shard, one of them is kept and rest is moved to \a home.
+         * @return true if unit was stolen.
+         */
+        bool steal( Shard &home ) noexcept;
+
+        /**
+         * Adds units to shard and wakes sleeping takers.
+         */
+        void publish( Shard &shard, uint32_t count ) noexcept;
+
+    private:
+        std::unique_ptr<Shard[]> shards;    /**< Per-CPU shards. */
+        uint32_t shard_count;               /**< Number of shards. */
+        uint32_t generation = 0;            /**< Global futex word, changed whenever units are added while takers sleep. */
+        uint32_t sleepers = 0;              /**< Number of takers blocked on generation. */
+    };
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Monitor with shared and exclusive entry.
+     *
+     * Exclusive entry is yarn::Monitor; lock, every wait_for and wait_until, notify, unlock, signal_all,
+     * signal_and_unlock and cells have same semantics, so code using Monitor can switch to SharedMonitor
+     * without changes. Threads that only read guarded state can enter in shared mode, check their predicates
+     * concurrently and wait for them with wait_for_shared.
+     * @par
+     * Shared owners are counted outside of monitor; shared entry is single atomic increment while monitor
+     * is not owned. Exclusive entry acquires monitor and then waits until shared owners leave, new shared
+     * entries wait for monitor meanwhile, so exclusive entry is not starved.
+     * @par
+     * Shared waiter is registered as ordinary waiter of Monitor. When its predicate is satisfied, monitor is
+     * handed over to it, it joins shared owners and releases monitor by unlock, so satisfied shared waiters
+     * are released one after another and exclusive waiter is served after them.
+     * @warning Exclusive entry must use members of SharedMonitor, calling them through reference
+     * to Monitor skips waiting for shared owners.
+     */
+    class SharedMonitor: public Monitor {
+    public:
+        SharedMonitor() = default;
+
+        /**
+         * Acquires monitor exclusively.
+         */
+        void lock() noexcept;
+
+        /**
+         * Tries to acquire monitor exclusively.
+         * @return false if monitor is owned or some thread owns it in shared mode.
+         */
+        [[nodiscard]] bool tryLock() noexcept;
+
+        /**
+         * Acquires monitor in shared mode.
+         */
+        void lock_shared() noexcept;
+
+        /**
+         * Tries to acquire monitor in shared mode.
+         * @return false if monitor is owned exclusively.
+         */
+        [[nodiscard]] bool tryLockShared() noexcept;
+
+        /**
+         * Releases shared ownership, predicates are not evaluated.
+         */
+        void unlock_shared() noexcept;
+
+        /**
+         * Same as Monitor::wait_for( Callable_T ), caller owns monitor exclusively when wait_for returns.
+         */
+        template <typename Callable_T>
+        void wait_for( Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key_buckets;
+            wait_exclusive( node, nullptr );
+        }
+
+        /**
+         * Same as Monitor::wait_for( uint32_t, Callable_T ), caller owns monitor exclusively when wait_for returns.
+         */
+        template <typename Callable_T>
+        void wait_for( uint32_t key, Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key % key_buckets;
+            wait_exclusive( node, nullptr );
+        }
+
+        /**
+         * Same as Monitor::wait_until, caller owns monitor exclusively in either case.
+         * @throws yarn::TimeoutExpiredException
+         */
+        template <typename Callable_T>
+        void wait_until( std::chrono::steady_clock::time_point deadline, Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            const struct timespec abs_deadline = _to_timespec( deadline );
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key_buckets;
+            if( !wait_exclusive( node, &abs_deadline ) )
+                throw TimeoutExpiredException( "Timeout expired before predicate was satisfied." );
+        }
+
+        /**
+         * Same as Monitor::wait_for( std::stop_token, Callable_T ), caller owns monitor exclusively in either case.
+         * @return Result of predicate; false if wait was cancelled before predicate was satisfied.
+         */
+        template <typename Callable_T>
+        bool wait_for( std::stop_token token, Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key_buckets;
+            std::stop_callback on_stop( token, [&node]() noexcept { cancel( node ); } );
+            return wait_exclusive( node, nullptr );
+        }
+
+        /**
+         * Suspends shared owner until predicate evaluates to true.
+         * Caller owns monitor in shared mode again when wait_for_shared returns.
+         * @tparam Callable_T Predicate type.
+         * @param predicate Callable object that returns true when wait should end, must only read guarded state.
+         * @note Satisfied predicate is checked without acquiring monitor.
+         */
+        template <typename Callable_T>
+        void wait_for_shared( Callable_T predicate ) {
+            static_assert( std::is_nothrow_invocable_r_v<bool, Callable_T>,
+                    "Predicate must be callable with return type bool." );
+
+            if( predicate() )
+                return;
+
+            LockNode node{ PredicateRef( predicate ) };
+            node.bucket = key_buckets;
+            wait_shared( node );
+        }
+
+    protected:
+        /**
+         * Waits as exclusive waiter of Monitor, then waits until shared owners leave.
+         * @return Result of Monitor::wait.
+         */
+        bool wait_exclusive( LockNode &node, const struct timespec *deadline ) noexcept;
+
+        /**
+         * Leaves shared owners, waits as waiter of Monitor and joins shared owners again.
+         */
+        void wait_shared( LockNode &node ) noexcept;
+
+        /**
+         * Blocks owner of monitor until all shared owners leave.
+         */
+        void drain() noexcept;
+
+    private:
+        uint32_t readers = 0;   /**< Futex word; number of shared owners, including entries backing off. */
+        uint32_t draining = 0;  /**< Owner of monitor waits for shared owners to leave. */
+    };
+}
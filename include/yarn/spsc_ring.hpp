@@ -0,0 +1,196 @@
+#pragma once
+#include "primitives.hpp"
+#include "event_count.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+
+namespace yarn {
+    /**
+     * @brief Bounded single-producer single-consumer ring.
+     *
+     * Producer owns tail and consumer owns head, each on own cache line together with cached copy
+     * of the other index. Index of other side is reloaded only when cached copy says ring is full
+     * or empty, so in steady state neither side reads cache line written by the other one except slots.
+     * Batch operations publish or consume many items by single store of index.
+     * @par
+     * Blocking ring (\a Blocking = true) adds push and pop parking on EventCount; every publish then costs
+     * additional fence and load to find out if other side is parked. Non-blocking ring has only try operations.
+     * @tparam T Item type, must be default constructible and movable.
+     * @tparam Blocking Ring supports blocking push and pop.
+     * @warning Only one thread may push and only one thread may pop at a time.
+     */
+    template <typename T, bool Blocking = false>
+    class SpscRing {
+    public:
+        /**
+         * Constructor of SpscRing.
+         * @param [in] capacity Minimal capacity, rounded up to power of 2.
+         * @throws std::invalid_argument if \a capacity is greater than 2^31.
+         */
+        explicit SpscRing( uint32_t capacity ) {
+            const uint32_t size = _ring_capacity( capacity );
+            mask = size - 1;
+            items = std::make_unique<T[]>( size );
+        }
+
+        SpscRing( const SpscRing & ) = delete;
+
+        SpscRing &operator=( const SpscRing & ) = delete;
+
+        /**
+         * Tries, pushing item.
+         * @param [in] item Pushed item, moved from only on success.
+         * @return false if ring is full.
+         */
+        template <typename Item_T>
+        [[nodiscard]] bool tryPush( Item_T &&item ) noexcept {
+            if( tail - cached_head > mask ) {
+                cached_head = __atomic_load_n( &head, __ATOMIC_ACQUIRE );
+                if( tail - cached_head > mask )
+                    return false;
+            }
+
+            items[ tail & mask ] = std::forward<Item_T>( item );
+            publish_tail( tail + 1 );
+            return true;
+        }
+
+        /**
+         * Tries, popping item.
+         * @param [out] item Popped item.
+         * @return false if ring is empty.
+         */
+        [[nodiscard]] bool tryPop( T &item ) noexcept {
+            if( cached_tail == head ) {
+                cached_tail = __atomic_load_n( &tail, __ATOMIC_ACQUIRE );
+                if( cached_tail == head )
+                    return false;
+            }
+
+            item = std::move( items[ head & mask ] );
+            publish_head( head + 1 );
+            return true;
+        }
+
+        /**
+         * Tries, pushing up to \a count items, published by single store.
+         * @param [in] source Pushed items, moved from if pushed.
+         * @param [in] count Number of items.
+         * @return Number of pushed items, they are prefix of \a source.
+         */
+        [[nodiscard]] uint32_t tryPush_n( T *source, uint32_t count ) noexcept {
+            uint64_t free = mask + 1 - ( tail - cached_head );
+            if( free < count ) {
+                cached_head = __atomic_load_n( &head, __ATOMIC_ACQUIRE );
+                free = mask + 1 - ( tail - cached_head );
+            }
+
+            auto pushed = static_cast<uint32_t>( std::min<uint64_t>( free, count ) );
+            for( uint32_t i = 0; i < pushed; i++ )
+                items[ ( tail + i ) & mask ] = std::move( source[ i ] );
+            if( pushed != 0 )
+                publish_tail( tail + pushed );
+            return pushed;
+        }
+
+        /**
+         * Tries, popping up to \a count items, consumed by single store.
+         * @param [out] destination Buffer for popped items.
+         * @param [in] count Capacity of buffer.
+         * @return Number of popped items.
+         */
+        [[nodiscard]] uint32_t tryPop_n( T *destination, uint32_t count ) noexcept {
+            uint64_t available = cached_tail - head;
+            if( available < count ) {
+                cached_tail = __atomic_load_n( &tail, __ATOMIC_ACQUIRE );
+                available = cached_tail - head;
+            }
+
+            auto popped = static_cast<uint32_t>( std::min<uint64_t>( available, count ) );
+            for( uint32_t i = 0; i < popped; i++ )
+                destination[ i ] = std::move( items[ ( head + i ) & mask ] );
+            if( popped != 0 )
+                publish_head( head + popped );
+            return popped;
+        }
+
+        /**
+         * Pushes item, parks while ring is full.
+         * @param [in] item Pushed item.
+         */
+        template <typename Item_T>
+        void push( Item_T &&item ) noexcept requires Blocking {
+            while( !tryPush( std::forward<Item_T>( item ) ) ) {
+                EventCount::Key key = not_full.prepare_wait();
+                if( tryPush( std::forward<Item_T>( item ) ) ) {
+                    not_full.cancel_wait();
+                    return;
+                }
+                not_full.commit_wait( key );
+            }
+        }
+
+        /**
+         * Pops item, parks while ring is empty.
+         * @return Popped item.
+         */
+        T pop() noexcept requires Blocking {
+            T item{};
+            while( !tryPop( item ) ) {
+                EventCount::Key key = not_empty.prepare_wait();
+                if( tryPop( item ) ) {
+                    not_empty.cancel_wait();
+                    break;
+                }
+                not_empty.commit_wait( key );
+            }
+            return item;
+        }
+
+        /**
+         * Capacity of ring.
+         */
+        [[nodiscard]] uint32_t capacity() const noexcept {
+            return static_cast<uint32_t>( mask + 1 );
+        }
+
+    protected:
+        /**
+         * Publishes items up to \a position to consumer.
+         */
+        void publish_tail( uint64_t position ) noexcept {
+            __atomic_store_n( &tail, position, __ATOMIC_RELEASE );
+            if constexpr( Blocking )
+                not_empty.notify_one();
+        }
+
+        /**
+         * Releases slots up to \a position to producer.
+         */
+        void publish_head( uint64_t position ) noexcept {
+            __atomic_store_n( &head, position, __ATOMIC_RELEASE );
+            if constexpr( Blocking )
+                not_full.notify_one();
+        }
+
+        /**
+         * @brief Empty placeholder of EventCount in non-blocking ring.
+         */
+        struct NoEvent {};
+
+        using Event_T = std::conditional_t<Blocking, EventCount, NoEvent>;
+
+    private:
+        alignas( 64 ) uint64_t tail = 0;        /**< Position after newest item, written by producer. */
+        uint64_t cached_head = 0;               /**< Producer's copy of head. */
+        alignas( 64 ) uint64_t head = 0;        /**< Position of oldest item, written by consumer. */
+        uint64_t cached_tail = 0;               /**< Consumer's copy of tail. */
+        alignas( 64 ) std::unique_ptr<T[]> items;   /**< Slots of ring. */
+        uint64_t mask;                          /**< Capacity - 1. */
+        [[no_unique_address]] Event_T not_empty;    /**< Parked consumer. */
+        [[no_unique_address]] Event_T not_full;     /**< Parked producer. */
+    };
+}
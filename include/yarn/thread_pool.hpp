@@ -0,0 +1,350 @@
+#pragma once
+#include "primitives.hpp"
+#include "event_count.hpp"
+
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+namespace yarn {
+    class ThreadPool;
+
+    /**
+     * @brief Unit of work scheduled by ThreadPool.
+     *
+     * Task is type-erased by function pointer, concrete task is allocated together with its future state.
+     */
+    struct Task {
+        Task *next = nullptr;                   /**< Next task in injection queue. */
+        void ( *execute )( Task * ) noexcept;   /**< Runs task of concrete type. */
+    };
+
+
+    /**
+     * @brief Chase-Lev work-stealing deque of tasks.
+     *
+     * Owner thread pushes and pops tasks at bottom without atomic read-modify-write, except when
+     * single task is left; other threads steal from top by compare-and-swap.
+     * Buffer grows when full, replaced buffers are kept until destruction because thieves may still read them.
+     */
+    class WorkStealingDeque {
+    public:
+        /**
+         * Constructor of WorkStealingDeque.
+         * @param [in] capacity Initial capacity, must be power of 2.
+         */
+        explicit WorkStealingDeque( uint32_t capacity = 256 );
+
+        ~WorkStealingDeque();
+
+        WorkStealingDeque( const WorkStealingDeque & ) = delete;
+
+        WorkStealingDeque &operator=( const WorkStealingDeque & ) = delete;
+
+        /**
+         * Pushes task to bottom.
+         * @param [in] task Pushed task.
+         * @note Must be called by owner only.
+         */
+        void push( Task *task );
+
+        /**
+         * Pops newest task from bottom.
+         * @return Task or nullptr if deque is empty.
+         * @note Must be called by owner only.
+         */
+        Task *pop() noexcept;
+
+        /**
+         * Steals oldest task from top.
+         * @return Task or nullptr if deque is empty.
+         */
+        Task *steal() noexcept;
+
+        /**
+         * Checks if deque seems empty.
+         */
+        [[nodiscard]] bool empty() const noexcept;
+
+    protected:
+        /**
+         * @brief Circular array of tasks.
+         */
+        struct Buffer {
+            int64_t mask;               /**< Capacity - 1. */
+            Task **slots;               /**< Tasks indexed by position & mask. */
+            Buffer *previous;           /**< Replaced buffer, freed on destruction. */
+        };
+
+        /**
+         * Allocates buffer of double capacity and copies tasks between \a top and \a bottom.
+         */
+        static Buffer *grow( Buffer *old, int64_t top, int64_t bottom );
+
+    private:
+        alignas( 64 ) int64_t top = 0;      /**< Position of oldest task, moved by thieves. */
+        alignas( 64 ) int64_t bottom = 0;   /**< Position after newest task, moved by owner. */
+        Buffer *buffer;                     /**< Current buffer. */
+    };
+
+
+    /**
+     * @brief Shared state of Future and its task, allocated once per task.
+     * @tparam T Result type.
+     */
+    template <typename T>
+    struct FutureState : Task {
+        using Stored_T = std::conditional_t<std::is_void_v<T>, bool, T>;
+
+        /**
+         * Completion state used as futex word; 0- running, 1- done, 2- running and some thread waits.
+         */
+        uint32_t done = 0;
+        uint32_t references = 2;                    /**< Owned by task and by future. */
+        ThreadPool *pool = nullptr;                 /**< Pool running task, waiting workers help it. */
+        std::optional<Stored_T> result;             /**< Result of task. */
+        std::exception_ptr error;                   /**< Exception thrown by task. */
+        void ( *destroy )( FutureState * ) noexcept = nullptr;  /**< Deletes concrete task. */
+
+        /**
+         * Drops one reference, last one deletes task.
+         */
+        void release() noexcept {
+            if( __sync_sub_and_fetch( &references, 1 ) == 0 )
+                destroy( this );
+        }
+    };
+
+
+    /**
+     * @brief Concrete task storing callable object next to future state.
+     * @tparam T Result type.
+     * @tparam Callable_T Type of callable object.
+     */
+    template <typename T, typename Callable_T>
+    struct Job : FutureState<T> {
+        Callable_T function;    /**< Executed callable object. */
+
+        Job( Callable_T &&function, ThreadPool *pool )
+            : function( std::move( function ) ) {
+            this->pool = pool;
+            this->execute = run;
+            this->destroy = []( FutureState<T> *state ) noexcept {
+                delete static_cast<Job *>( state );
+            };
+        }
+
+        /**
+         * Runs function, stores result or exception and wakes waiting threads.
+         */
+        static void run( Task *task ) noexcept {
+            auto *job = static_cast<Job *>( static_cast<FutureState<T> *>( task ) );
+            try {
+                if constexpr( std::is_void_v<T> ) {
+                    job->function();
+                    job->result.emplace( true );
+                }
+                else job->result.emplace( job->function() );
+            }
+            catch( ... ) {
+                job->error = std::current_exception();
+            }
+
+            if( __atomic_exchange_n( &job->done, 1, __ATOMIC_ACQ_REL ) == 2 )
+                _simple_futex( &job->done, FUTEX_WAKE, INT32_MAX );
+            job->release();
+        }
+    };
+
+
+    /**
+     * @brief Result of task submitted to ThreadPool.
+     *
+     * Future is move only handle to state shared with task, it costs no allocation besides task itself.
+     * Worker of pool waiting for future runs other tasks meanwhile, so tasks can wait for
+     * tasks they submitted without exhausting workers.
+     * @tparam T Result type.
+     */
+    template <typename T>
+    class Future {
+    public:
+        Future() = default;
+
+        Future( const Future & ) = delete;
+
+        Future &operator=( const Future & ) = delete;
+
+        Future( Future &&other ) noexcept
+            : state( other.state ) {
+            other.state = nullptr;
+        }
+
+        Future &operator=( Future &&other ) noexcept {
+            if( this != &other ) {
+                if( state != nullptr )
+                    state->release();
+                state = other.state;
+                other.state = nullptr;
+            }
+            return *this;
+        }
+
+        ~Future() {
+            if( state != nullptr )
+                state->release();
+        }
+
+        /**
+         * Checks if future refers to task.
+         */
+        [[nodiscard]] bool valid() const noexcept {
+            return state != nullptr;
+        }
+
+        /**
+         * Checks if task finished.
+         * @return false if future does not refer to task.
+         */
+        [[nodiscard]] bool ready() const noexcept {
+            return valid() && __atomic_load_n( &state->done, __ATOMIC_ACQUIRE ) == 1;
+        }
+
+        /**
+         * Blocks until task finished; worker of the same pool runs other tasks meanwhile.
+         * Returns immediately if future does not refer to task.
+         */
+        void wait() const noexcept;
+
+        /**
+         * Waits for task and returns its result.
+         * @return Result of task, moved out of future.
+         * @throws Exception thrown by task.
+         * @note Can be called only once, and only on valid future.
+         */
+        T get();
+
+    private:
+        friend class ThreadPool;
+
+        explicit Future( FutureState<T> *state ) noexcept
+            : state( state ) {}
+
+        FutureState<T> *state = nullptr;    /**< Shared state, nullptr for empty future. */
+    };
+
+
+    /**
+     * @brief Work-stealing pool of worker threads.
+     *
+     * Every worker owns WorkStealingDeque; task submitted from worker is pushed to its own deque and skips
+     * global queue. Tasks submitted from other threads go to global injection queue.
+     * Worker without task takes task from own deque, then from injection queue and then steals from
+     * other workers, starting at random victim.
+     * @par
+     * Idle workers park on EventCount; submit wakes one worker only if some worker is parked,
+     * so busy pool submits without sys-call.
+     * @note Destructor finishes every submitted task before joining workers.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * Constructor of ThreadPool.
+         * @param [in] thread_count Number of workers, 0 for number of hardware threads.
+         */
+        explicit ThreadPool( uint32_t thread_count = 0 );
+
+        ~ThreadPool();
+
+        ThreadPool( const ThreadPool & ) = delete;
+
+        ThreadPool &operator=( const ThreadPool & ) = delete;
+
+        /**
+         * Schedules callable object to be run by some worker.
+         * @tparam Callable_T Type of callable object.
+         * @param function Callable object without arguments.
+         * @return Future of result of \a function.
+         */
+        template <typename Callable_T>
+        auto submit( Callable_T function ) -> Future<std::invoke_result_t<Callable_T &>> {
+            using Result_T = std::invoke_result_t<Callable_T &>;
+            static_assert( !std::is_reference_v<Result_T>, "Task can not return reference." );
+
+            auto *job = new Job<Result_T, Callable_T>( std::move( function ), this );
+            schedule( job );
+            return Future<Result_T>( job );
+        }
+
+        /**
+         * Number of workers.
+         */
+        [[nodiscard]] uint32_t size() const noexcept;
+
+    protected:
+        template <typename T>
+        friend class Future;
+
+        /**
+         * @brief Worker thread with its deque, aligned to avoid false sharing between workers.
+         */
+        struct alignas( 64 ) Worker {
+            WorkStealingDeque deque;    /**< Tasks of worker. */
+            uint32_t seed;              /**< State of random victim selection. */
+            std::thread thread;         /**< Thread of worker. */
+        };
+
+        /**
+         * Pushes task to deque of current worker or to injection queue, and wakes parked worker.
+         */
+        void schedule( Task *task );
+
+        /**
+         * Waits until \a done is 1; worker of this pool runs other tasks meanwhile.
+         */
+        void await( uint32_t *done ) noexcept;
+
+        /**
+         * Finds task in own deque, injection queue or deques of other workers.
+         * @param [in] self Current worker, nullptr for foreign thread.
+         * @return Task or nullptr if no task was found.
+         */
+        Task *find_task( Worker *self ) noexcept;
+
+        /**
+         * Main loop of worker.
+         */
+        void run( Worker *self ) noexcept;
+
+        static thread_local ThreadPool *current_pool;   /**< Pool of current worker thread. */
+        static thread_local Worker *current_worker;     /**< Current worker thread. */
+
+    private:
+        std::vector<std::unique_ptr<Worker>> workers;   /**< Workers of pool. */
+        Lock injection_lock;                /**< Protects injection queue. */
+        Task *injection_head = nullptr;     /**< Oldest task submitted from foreign thread. */
+        Task *injection_tail = nullptr;     /**< Newest task submitted from foreign thread. */
+        uint32_t injected = 0;              /**< Number of tasks in injection queue. */
+        EventCount idle;                    /**< Parked workers. */
+        uint32_t stopping = 0;              /**< Pool is being destroyed. */
+    };
+
+
+    template <typename T>
+    void Future<T>::wait() const noexcept {
+        if( valid() && !ready() )
+            state->pool->await( &state->done );
+    }
+
+    template <typename T>
+    T Future<T>::get() {
+        wait();
+        if( state->error )
+            std::rethrow_exception( state->error );
+
+        if constexpr( !std::is_void_v<T> )
+            return std::move( *state->result );
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "primitives.hpp"
+#include "weighted_waiters.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Semaphore with 64-bit capacity and weighted acquisitions, suitable for budgets in bytes.
+     *
+     * Every blocked thread waits on its own futex word and release hands budget directly to waiters,
+     * so releasing large weight wakes exactly the waiters that can proceed and nobody else.
+     * @par
+     * WeightedSemaphore::Policy::fifo serves waiters strictly in arrival order; while the oldest waiter
+     * does not fit, younger ones wait too, so large weights can not be starved.
+     * WeightedSemaphore::Policy::best_fit repeatedly serves the largest waiter that fits into available budget,
+     * this keeps budget utilized, but large weights may be starved by stream of smaller ones.
+     * Waiters are kept sorted by weight, so release serves them in single pass over queue.
+     */
+    class WeightedSemaphore {
+    public:
+        /**
+         * Order in which released budget is handed to waiters.
+         */
+        using Policy = WeightedWaiters::Policy;
+
+        /**
+         * Constructor of WeightedSemaphore.
+         * @param [in] capacity Total budget, all of it is available initially.
+         * @param [in] policy Order of serving waiters.
+         */
+        explicit WeightedSemaphore( uint64_t capacity, Policy policy = Policy::fifo ) noexcept;
+
+        WeightedSemaphore( const WeightedSemaphore & ) = delete;
+
+        WeightedSemaphore &operator=( const WeightedSemaphore & ) = delete;
+
+        /**
+         * Acquires \a weight of budget, blocks until it is handed over.
+         * @param [in] weight Acquired part of budget.
+         * @warning Weight larger than capacity can never be acquired.
+         */
+        void acquire( uint64_t weight ) noexcept;
+
+        /**
+         * Same as WeightedSemaphore::acquire but if budget is not handed over before deadline,
+         * exception is raised and nothing is acquired.
+         * @param [in] weight Acquired part of budget.
+         * @param [in] deadline Point in time of std::chrono::steady_clock.
+         * @throws yarn::TimeoutExpiredException
+         */
+        void acquire_until( uint64_t weight, std::chrono::steady_clock::time_point deadline );
+
+        /**
+         * Tries, acquiring \a weight of budget immediately.
+         * @param [in] weight Acquired part of budget.
+         * @return true if budget was acquired.
+         * @note With fifo policy fails if any thread is blocked, even if budget is available.
+         */
+        [[nodiscard]] bool tryAcquire( uint64_t weight ) noexcept;
+
+        /**
+         * Returns \a weight of budget and hands it over to waiters which fit.
+         * @param [in] weight Returned part of budget.
+         */
+        void release( uint64_t weight ) noexcept;
+
+    private:
+        WeightedWaiters waiters;    /**< Available budget and blocked threads. */
+    };
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "primitives.hpp"
+
+
+namespace yarn {
+    /**
+     * @brief Queue of threads waiting for weighted part of budget, used by FairSemaphore and WeightedSemaphore.
+     *
+     * Every blocked thread waits on futex word in its own stack node and release hands budget directly
+     * to waiters, so release wakes exactly the waiters that can proceed.
+     * State of waiter changes only under internal lock; waiter that times out or is cancelled removes itself
+     * before it returns, and granted waiter is removed before it is woken, so node is never touched
+     * after its thread could have left.
+     */
+    class WeightedWaiters {
+    public:
+        /**
+         * @brief Order in which released budget is handed to waiters.
+         */
+        enum class Policy {
+            fifo,       /**< Oldest waiter first, younger waiters never overtake it. */
+            best_fit    /**< Largest waiter that fits first. */
+        };
+
+        /**
+         * Constructor of WeightedWaiters.
+         * @param [in] available Initially available budget.
+         * @param [in] policy Order of serving waiters.
+         */
+        WeightedWaiters( uint64_t available, Policy policy ) noexcept;
+
+        WeightedWaiters( const WeightedWaiters & ) = delete;
+
+        WeightedWaiters &operator=( const WeightedWaiters & ) = delete;
+
+        /**
+         * Tries, acquiring \a weight of budget immediately.
+         * @return true if budget was acquired.
+         * @note With fifo policy fails if any thread is blocked, even if budget is available.
+         */
+        [[nodiscard]] bool tryAcquire( uint64_t weight ) noexcept;
+
+        /**
+         * Acquires \a weight of budget, blocks until it is handed over or deadline expires.
+         * @param [in] weight Acquired part of budget.
+         * @param [in] deadline Absolute time of CLOCK_MONOTONIC, nullptr for no deadline.
+         * @return false if deadline expired and nothing was acquired.
+         */
+        bool acquire( uint64_t weight, const struct timespec *deadline = nullptr ) noexcept;
+
+        /**
+         * Acquires \a weight of budget, blocks until it is handed over or stop is requested on \a token.
+         * @param [in] weight Acquired part of budget.
+         * @param [in] token Stop token cancelling the wait.
+         * @return false if wait was cancelled and nothing was acquired.
+         */
+        bool acquire( uint64_t weight, std::stop_token token ) noexcept;
+
+        /**
+         * Returns \a weight of budget and hands it over to waiters which fit.
+         */
+        void release( uint64_t weight ) noexcept;
+
+    protected:
+        /**
+         * @brief Blocked thread, lives in its stack frame.
+         */
+        struct Node {
+            Node *prev = nullptr;   /**< Previous node in queue. */
+            Node *next = nullptr;   /**< Next node in queue. */
+            uint64_t weight = 0;    /**< Requested part of budget. */
+
+            /**
+             * State of thread, changed only under queue_lock; 0- thread should wait, 1- budget was handed over,
+             * 2- wait was cancelled and thread was removed from queue.
+             */
+            uint32_t state = 0;
+        };
+
+        /**
+         * Enqueues thread and blocks until budget is handed over, deadline expires or wait is cancelled.
+         * @return true if budget was handed over.
+         */
+        bool wait( Node &node, const struct timespec *deadline ) noexcept;
+
+        /**
+         * Removes thread from queue and wakes it, unless budget was already handed over to it.
+         */
+        void cancel( Node &node ) noexcept;
+
+        /**
+         * Queues node; fifo appends it, best_fit keeps queue sorted by weight, heaviest first.
+         */
+        void link( Node &node ) noexcept;
+
+        /**
+         * Removes node from queue.
+         */
+        void erase( Node &node ) noexcept;
+
+        /**
+         * Hands available budget to waiters according to policy, in single pass over queue.
+         */
+        void grant() noexcept;
+
+        /**
+         * Removes waiter from queue, debits its weight and wakes it.
+         */
+        void hand_over( Node &node ) noexcept;
+
+    private:
+        Lock queue_lock;                /**< Protects available budget and queue. */
+        uint64_t available;             /**< Budget not acquired by any thread. */
+        Node *head = nullptr;           /**< First waiter to be served. */
+        Node *tail = nullptr;           /**< Last waiter to be served. */
+        Policy policy;                  /**< Order of serving waiters. */
+    };
+}
@@ -0,0 +1,157 @@
+#include "adaptive_limiter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sched.h>
+#include <stdexcept>
+
+
+using namespace yarn;
+
+static uint32_t
+starting_limit( uint32_t initial_limit, uint32_t min_limit, uint32_t max_limit ) {
+    // limit of 0 would block every acquire forever
+    if( min_limit == 0 || min_limit > max_limit )
+        throw std::invalid_argument( "Limits must satisfy 0 < min_limit <= max_limit." );
+
+    return std::clamp( initial_limit, min_limit, max_limit );
+}
+
+
+AdaptiveLimiter::AdaptiveLimiter( Algorithm algorithm, uint32_t initial_limit,
+                                  uint32_t min_limit, uint32_t max_limit, uint32_t window )
+    : permits( starting_limit( initial_limit, min_limit, max_limit ) ),
+      current_limit( std::clamp( initial_limit, min_limit, max_limit ) ), estimate( current_limit ),
+      algorithm( algorithm ), min_limit( min_limit ), max_limit( max_limit ), window( std::max( window, 1u ) ) {}
+
+void AdaptiveLimiter::acquire() noexcept {
+    permits.take();
+}
+
+[[nodiscard]] bool AdaptiveLimiter::tryAcquire() noexcept {
+    return permits.tryTake();
+}
+
+void AdaptiveLimiter::release( uint32_t latency_us, bool failed ) noexcept {
+    Window *current;
+    while( true ) {
+        uint32_t index = __atomic_load_n( &active, __ATOMIC_ACQUIRE );
+        current = &windows[ index ];
+        __sync_add_and_fetch( &current->writers, 1 );
+
+        // full barrier pairs with switch of windows; either updater waits for us or we see the switch
+        if( __atomic_load_n( &active, __ATOMIC_SEQ_CST ) == index )
+            break;
+        __sync_sub_and_fetch( &current->writers, 1 );
+    }
+
+    __sync_fetch_and_add( &current->latency_sum, latency_us );
+    if( failed )
+        __sync_fetch_and_add( &current->failures, 1 );
+    uint32_t seen = __sync_add_and_fetch( &current->samples, 1 );
+    __sync_sub_and_fetch( &current->writers, 1 );
+
+    // operations in flight including this one, before its permit is returned
+    uint32_t free_permits = permits.value();
+    uint32_t in_flight = current_limit > free_permits ? current_limit - free_permits : 0;
+    for( uint32_t peak = peak_in_flight; in_flight > peak; peak = peak_in_flight )
+        if( __sync_bool_compare_and_swap( &peak_in_flight, peak, in_flight ) )
+            break;
+
+    // permit is withheld when limit was decreased below number of operations in flight
+    while( true ) {
+        uint32_t owed = debt;
+        if( owed == 0 ) {
+            permits.give();
+            break;
+        }
+        if( __sync_bool_compare_and_swap( &debt, owed, owed - 1 ) )
+            break;
+    }
+
+    if( seen < window || !__sync_bool_compare_and_swap( &updating, 0, 1 ) )
+        return;
+
+    // window was already closed by other thread
+    if( &windows[ __atomic_load_n( &active, __ATOMIC_ACQUIRE ) ] != current ) {
+        __sync_lock_release( &updating );
+        return;
+    }
+
+    // new samples go to other window, closed one is read once its last writer leaves
+    __sync_fetch_and_xor( &active, 1 );
+    while( __atomic_load_n( &current->writers, __ATOMIC_ACQUIRE ) != 0 )
+        sched_yield();
+
+    uint64_t sum = current->latency_sum;
+    uint32_t count = current->samples, failed_count = current->failures;
+    current->latency_sum = 0;
+    current->samples = 0;
+    current->failures = 0;
+
+    update( sum, count, failed_count );
+    __sync_lock_release( &updating );
+}
+
+[[nodiscard]] uint32_t AdaptiveLimiter::limit() const noexcept {
+    return __atomic_load_n( &current_limit, __ATOMIC_ACQUIRE );
+}
+
+void AdaptiveLimiter::update( uint64_t sum, uint32_t count, uint32_t failed_count ) noexcept {
+    double latency = static_cast<double>( sum ) / count;
+    uint32_t peak = __sync_fetch_and_and( &peak_in_flight, 0 );
+
+    if( algorithm == Algorithm::aimd ) {
+        if( failed_count != 0 )
+            estimate *= backoff;
+        // application does not use limit, growing it would be meaningless
+        else if( 2 * peak >= current_limit )
+            estimate += 1;
+    }
+    else {
+        if( long_latency == 0 )
+            long_latency = latency;
+        else long_latency = long_latency * 0.95 + latency * 0.05;
+
+        // latency dropped much below average; forget old average faster
+        if( long_latency / latency > 2 )
+            long_latency *= 0.9;
+
+        double gradient = std::clamp( tolerance * long_latency / std::max( latency, 1.0 ), 0.5, 1.0 );
+        double target = estimate * gradient + std::sqrt( estimate );
+        estimate = estimate * ( 1 - smoothing ) + target * smoothing;
+    }
+
+    estimate = std::clamp( estimate, static_cast<double>( min_limit ), static_cast<double>( max_limit ) );
+    resize( static_cast<uint32_t>( estimate ) );
+}
+
+void AdaptiveLimiter::resize( uint32_t new_limit ) noexcept {
+    uint32_t old_limit = current_limit;
+    __atomic_store_n( &current_limit, new_limit, __ATOMIC_RELEASE );
+
+    if( new_limit > old_limit ) {
+        uint32_t grow = new_limit - old_limit;
+
+        // cancel withheld permits first
+        while( grow != 0 ) {
+            uint32_t owed = debt;
+            if( owed == 0 )
+                break;
+            uint32_t paid = std::min( owed, grow );
+            if( __sync_bool_compare_and_swap( &debt, owed, owed - paid ) )
+                grow -= paid;
+        }
+        if( grow != 0 )
+            permits.give( grow );
+        return;
+    }
+
+    // free permits are removed at once, permits in use are withheld when released
+    for( uint32_t shrink = old_limit - new_limit; shrink != 0; shrink-- ) {
+        if( !permits.tryTake() ) {
+            __sync_fetch_and_add( &debt, shrink );
+            return;
+        }
+    }
+}
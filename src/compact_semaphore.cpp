@@ -0,0 +1,52 @@
+#include "compact_semaphore.hpp"
+
+
+using namespace yarn;
+
+CompactSemaphore::CompactSemaphore( uint32_t initial_value ) noexcept
+    : word( initial_value & ~waiter_bit ) {}
+
+void CompactSemaphore::take() noexcept {
+    while( true ) {
+        uint32_t current = word;
+
+        if( current & ~waiter_bit ) {
+            if( __sync_bool_compare_and_swap( &word, current, current - 1 ) )
+                return;
+            continue;
+        }
+
+        // announce sleeping, giver that changed word meanwhile makes compare-and-swap fail
+        if( !( current & waiter_bit ) && !__sync_bool_compare_and_swap( &word, current, current | waiter_bit ) )
+            continue;
+
+        _simple_futex( &word, FUTEX_WAIT, current | waiter_bit );
+    }
+}
+
+[[nodiscard]] bool CompactSemaphore::tryTake() noexcept {
+    while( true ) {
+        uint32_t current = word;
+        if( !( current & ~waiter_bit ) )
+            return false;
+        if( __sync_bool_compare_and_swap( &word, current, current - 1 ) )
+            return true;
+    }
+}
+
+void CompactSemaphore::give() noexcept {
+    give( 1 );
+}
+
+void CompactSemaphore::give( uint32_t count ) noexcept {
+    if( !( __sync_fetch_and_add( &word, count ) & waiter_bit ) )
+        return;
+
+    // sleepers which do not get unit set waiter bit again before sleeping
+    __sync_fetch_and_and( &word, ~waiter_bit );
+    _simple_futex( &word, FUTEX_WAKE, INT32_MAX );
+}
+
+[[nodiscard]] uint32_t CompactSemaphore::value() const noexcept {
+    return __atomic_load_n( &word, __ATOMIC_ACQUIRE ) & ~waiter_bit;
+}
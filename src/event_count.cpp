@@ -0,0 +1,55 @@
+#include "event_count.hpp"
+
+#include <cerrno>
+
+
+using namespace yarn;
+
+static_assert( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "EventCount expects epoch in upper half at higher address." );
+
+[[nodiscard]] EventCount::Key EventCount::prepare_wait() noexcept {
+    uint64_t previous = __sync_fetch_and_add( &state, waiter_inc );
+    return static_cast<Key>( previous >> 32 );
+}
+
+void EventCount::cancel_wait() noexcept {
+    __sync_fetch_and_sub( &state, waiter_inc );
+}
+
+void EventCount::commit_wait( Key key ) noexcept {
+    (void) commit_wait( key, nullptr );
+}
+
+[[nodiscard]] bool EventCount::commit_wait( Key key, const struct timespec *deadline ) noexcept {
+    bool notified = true;
+    while( __atomic_load_n( epoch(), __ATOMIC_ACQUIRE ) == key ) {
+        if( _deadline_futex( epoch(), key, deadline ) == -1 && errno == ETIMEDOUT ) {
+            notified = __atomic_load_n( epoch(), __ATOMIC_ACQUIRE ) != key;
+            break;
+        }
+    }
+    __sync_fetch_and_sub( &state, waiter_inc );
+    return notified;
+}
+
+void EventCount::notify_one() noexcept {
+    notify( 1 );
+}
+
+void EventCount::notify_all() noexcept {
+    notify( INT32_MAX );
+}
+
+void EventCount::notify( uint32_t count ) noexcept {
+    // pairs with prepare_wait, either waiter sees condition or we see waiter
+    __sync_synchronize();
+    if( static_cast<uint32_t>( __atomic_load_n( &state, __ATOMIC_RELAXED ) ) == 0 )
+        return;
+
+    __sync_fetch_and_add( &state, epoch_inc );
+    _simple_futex( epoch(), FUTEX_WAKE, count );
+}
+
+uint32_t *EventCount::epoch() noexcept {
+    return reinterpret_cast<uint32_t *>( &state ) + 1;
+}
@@ -0,0 +1,147 @@
+#include "fair_monitor.hpp"
+
+#include <ctime>
+
+
+using namespace yarn;
+
+static uint64_t
+now_us() {
+    struct timespec now{};
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return static_cast<uint64_t>( now.tv_sec ) * 1000000 + now.tv_nsec / 1000;
+}
+
+static bool
+older( uint32_t ticket, uint32_t other ) {
+    return static_cast<int32_t>( ticket - other ) < 0;
+}
+
+
+FairMonitor::FairMonitor( uint32_t barging_window_us ) noexcept
+    : barging_window( barging_window_us ) {}
+
+void FairMonitor::lock() noexcept {
+    Node node{};
+
+    queue_lock.lock();
+    if( !owned && may_barge() ) {
+        owned = true;
+        queue_lock.unlock();
+        return;
+    }
+
+    node.ticket = next_ticket++;
+    if( barging_window != 0 )
+        node.arrival_us = now_us();
+    push( entry_head, entry_tail, node );
+    queue_lock.unlock();
+
+    while( true ) {
+        while( node.state == 0 )
+            _simple_futex( &node.state, FUTEX_WAIT, 0 );
+
+        // monitor was handed over to us
+        if( node.state == 1 )
+            return;
+
+        // monitor was released inside of barging window, we compete but keep our place in queue
+        queue_lock.lock();
+        if( !owned ) {
+            owned = true;
+            erase( entry_head, entry_tail, node );
+            queue_lock.unlock();
+            return;
+        }
+        node.state = 0;
+        queue_lock.unlock();
+    }
+}
+
+[[nodiscard]] bool FairMonitor::tryLock() noexcept {
+    queue_lock.lock();
+    bool acquired = !owned && may_barge();
+    if( acquired )
+        owned = true;
+    queue_lock.unlock();
+
+    return acquired;
+}
+
+void FairMonitor::unlock() noexcept {
+    // owner may evaluate predicates and modify waiter list
+    Node *ready = waiter_head;
+    while( ready != nullptr && !( *ready->predicate )() )
+        ready = ready->next;
+
+    queue_lock.lock();
+    Node *head = entry_head;
+
+    if( ready != nullptr && ( head == nullptr || older( ready->ticket, head->ticket ) ) ) {
+        erase( waiter_head, waiter_tail, *ready );
+        ready->state = 1;
+        queue_lock.unlock();
+        _simple_futex( &ready->state, FUTEX_WAKE, 1 );
+        return;
+    }
+
+    if( head == nullptr ) {
+        owned = false;
+        queue_lock.unlock();
+        return;
+    }
+
+    if( barging_window == 0 || now_us() - head->arrival_us >= barging_window ) {
+        erase( entry_head, entry_tail, *head );
+        head->state = 1;
+        queue_lock.unlock();
+        _simple_futex( &head->state, FUTEX_WAKE, 1 );
+        return;
+    }
+
+    // inside of barging window; release monitor and let oldest thread compete for it
+    owned = false;
+    bool wake = head->state == 0;
+    head->state = 2;
+    queue_lock.unlock();
+    if( wake )
+        _simple_futex( &head->state, FUTEX_WAKE, 1 );
+}
+
+void FairMonitor::wait( Node &node ) noexcept {
+    queue_lock.lock();
+    node.ticket = next_ticket++;
+    queue_lock.unlock();
+
+    push( waiter_head, waiter_tail, node );
+    unlock();
+
+    while( node.state != 1 )
+        _simple_futex( &node.state, FUTEX_WAIT, 0 );
+}
+
+bool FairMonitor::may_barge() const noexcept {
+    if( entry_head == nullptr )
+        return true;
+
+    return barging_window != 0 && now_us() - entry_head->arrival_us < barging_window;
+}
+
+void FairMonitor::push( Node *&head, Node *&tail, Node &node ) noexcept {
+    node.prev = tail;
+    node.next = nullptr;
+    if( tail != nullptr )
+        tail->next = &node;
+    else head = &node;
+    tail = &node;
+}
+
+void FairMonitor::erase( Node *&head, Node *&tail, Node &node ) noexcept {
+    if( node.prev != nullptr )
+        node.prev->next = node.next;
+    else head = node.next;
+
+    if( node.next != nullptr )
+        node.next->prev = node.prev;
+    else tail = node.prev;
+}
@@ -0,0 +1,44 @@
+#include "fair_semaphore.hpp"
+
+
+using namespace yarn;
+
+FairSemaphore::FairSemaphore( uint32_t initial_value ) noexcept
+    : waiters( initial_value, WeightedWaiters::Policy::fifo ) {}
+
+void FairSemaphore::take() noexcept {
+    take_n( 1 );
+}
+
+void FairSemaphore::take_n( uint32_t count ) noexcept {
+    (void) waiters.acquire( count );
+}
+
+void FairSemaphore::take_until( uint32_t count, std::chrono::steady_clock::time_point deadline ) {
+    if( waiters.tryAcquire( count ) )
+        return;
+
+    const struct timespec abs_deadline = _to_timespec( deadline );
+    if( !waiters.acquire( count, &abs_deadline ) )
+        throw TimeoutExpiredException( "Timeout expired before take was possible." );
+}
+
+[[nodiscard]] bool FairSemaphore::take_n( uint32_t count, std::stop_token token ) noexcept {
+    return waiters.acquire( count, std::move( token ) );
+}
+
+[[nodiscard]] bool FairSemaphore::tryTake() noexcept {
+    return tryTake( 1 );
+}
+
+[[nodiscard]] bool FairSemaphore::tryTake( uint32_t count ) noexcept {
+    return waiters.tryAcquire( count );
+}
+
+void FairSemaphore::give() noexcept {
+    give( 1 );
+}
+
+void FairSemaphore::give( uint32_t count ) noexcept {
+    waiters.release( count );
+}
@@ -0,0 +1,223 @@
+#include "parking_lot.hpp"
+
+#include <cerrno>
+#include <sched.h>
+
+
+using namespace yarn;
+
+namespace {
+    /**
+     * @brief Parked thread, lives in its stack frame.
+     */
+    struct ParkNode {
+        const void *address;        /**< Address thread is parked on. */
+        ParkNode *next = nullptr;   /**< Next thread in bucket. */
+        intptr_t token = 0;         /**< Token handed over by unparker. */
+        uint32_t state = 0;         /**< 0- parked, 1- unparked; futex word. */
+    };
+
+    /**
+     * @brief Queue of threads parked on addresses with the same hash.
+     */
+    struct alignas( 64 ) Bucket {
+        Lock lock;                  /**< Protects queue. */
+        ParkNode *head = nullptr;   /**< Oldest parked thread. */
+        ParkNode *tail = nullptr;   /**< Newest parked thread. */
+    };
+
+    constexpr uint32_t bucket_bits = 9;
+    // constant-initialized, parking from constructors of other globals never sees unconstructed bucket
+    constinit Bucket buckets[ 1u << bucket_bits ];
+
+    Bucket &
+    bucket_of( const void *address ) {
+        auto key = static_cast<uint64_t>( reinterpret_cast<uintptr_t>( address ) );
+        return buckets[ ( key * 0x9E3779B97F4A7C15ull ) >> ( 64 - bucket_bits ) ];
+    }
+
+    /**
+     * Unlinks node following \a previous, nullptr previous means head.
+     */
+    void
+    unlink( Bucket &bucket, ParkNode *previous, ParkNode *node ) {
+        if( previous != nullptr )
+            previous->next = node->next;
+        else bucket.head = node->next;
+
+        if( bucket.tail == node )
+            bucket.tail = previous;
+    }
+}
+
+
+bool ParkingLot::park_conditionally( const void *address, const PredicateRef &validate,
+                                     const struct timespec *deadline, intptr_t *token ) noexcept {
+    Bucket &bucket = bucket_of( address );
+    ParkNode node{ address };
+
+    bucket.lock.lock();
+    if( !validate() ) {
+        bucket.lock.unlock();
+        return false;
+    }
+
+    if( bucket.tail != nullptr )
+        bucket.tail->next = &node;
+    else bucket.head = &node;
+    bucket.tail = &node;
+    bucket.lock.unlock();
+
+    bool expired = false;
+    while( __atomic_load_n( &node.state, __ATOMIC_ACQUIRE ) == 0 && !expired )
+        expired = _deadline_futex( &node.state, 0, deadline ) == -1 && errno == ETIMEDOUT;
+
+    if( expired ) {
+        bucket.lock.lock();
+        // unparker may have been faster than us
+        if( node.state == 0 ) {
+            ParkNode *previous = nullptr;
+            for( ParkNode *current = bucket.head; current != &node; current = current->next )
+                previous = current;
+            unlink( bucket, previous, &node );
+            bucket.lock.unlock();
+            return false;
+        }
+        bucket.lock.unlock();
+    }
+
+    if( token != nullptr )
+        *token = node.token;
+    return true;
+}
+
+ParkingLot::UnparkResult ParkingLot::unpark_one_with( const void *address, void *object,
+                                                      intptr_t ( *callback )( void *, UnparkResult ) noexcept ) noexcept {
+    Bucket &bucket = bucket_of( address );
+    UnparkResult result;
+
+    bucket.lock.lock();
+    ParkNode *previous = nullptr, *found = nullptr;
+    for( ParkNode *current = bucket.head; current != nullptr; current = current->next ) {
+        if( current->address != address ) {
+            if( found == nullptr )
+                previous = current;
+            continue;
+        }
+
+        if( found != nullptr ) {
+            result.have_more = true;
+            break;
+        }
+        found = current;
+    }
+
+    if( found != nullptr ) {
+        unlink( bucket, previous, found );
+        result.unparked = true;
+    }
+
+    intptr_t token = callback( object, result );
+    if( found != nullptr ) {
+        found->token = token;
+        __atomic_store_n( &found->state, 1, __ATOMIC_RELEASE );
+        _simple_futex( &found->state, FUTEX_WAKE, 1 );
+    }
+    bucket.lock.unlock();
+
+    return result;
+}
+
+uint32_t ParkingLot::unpark_all( const void *address, intptr_t token ) noexcept {
+    Bucket &bucket = bucket_of( address );
+    uint32_t count = 0;
+
+    bucket.lock.lock();
+    ParkNode *previous = nullptr, *current = bucket.head;
+    while( current != nullptr ) {
+        ParkNode *next = current->next;
+        if( current->address == address ) {
+            unlink( bucket, previous, current );
+            current->token = token;
+            __atomic_store_n( &current->state, 1, __ATOMIC_RELEASE );
+            _simple_futex( &current->state, FUTEX_WAKE, 1 );
+            count++;
+        }
+        else previous = current;
+        current = next;
+    }
+    bucket.lock.unlock();
+
+    return count;
+}
+
+
+void ByteLock::lock() noexcept {
+    if( __sync_bool_compare_and_swap( &bits, 0, locked ) )
+        return;
+    lock_slow();
+}
+
+[[nodiscard]] bool ByteLock::tryLock() noexcept {
+    while( true ) {
+        uint8_t current = bits;
+        if( current & locked )
+            return false;
+        if( __sync_bool_compare_and_swap( &bits, current, current | locked ) )
+            return true;
+    }
+}
+
+void ByteLock::unlock() noexcept {
+    if( __sync_bool_compare_and_swap( &bits, locked, 0 ) )
+        return;
+    unlock_slow();
+}
+
+void ByteLock::lock_slow() noexcept {
+    uint32_t spins = 0;
+
+    while( true ) {
+        uint8_t current = bits;
+
+        if( !( current & locked ) ) {
+            if( __sync_bool_compare_and_swap( &bits, current, current | locked ) )
+                return;
+            continue;
+        }
+
+        // nobody is parked yet, spinning is cheaper than parking for short critical sections
+        if( !( current & parked ) && spins < spin_count ) {
+            spins++;
+            sched_yield();
+            continue;
+        }
+
+        if( !( current & parked ) && !__sync_bool_compare_and_swap( &bits, current, current | parked ) )
+            continue;
+
+        ParkingLot::park( &bits, [this]() noexcept {
+            return __atomic_load_n( &bits, __ATOMIC_ACQUIRE ) == ( locked | parked );
+        } );
+    }
+}
+
+void ByteLock::unlock_slow() noexcept {
+    while( true ) {
+        uint8_t current = bits;
+
+        // parked thread left by timeout or validation, plain release
+        if( current == locked ) {
+            if( __sync_bool_compare_and_swap( &bits, locked, 0 ) )
+                return;
+            continue;
+        }
+
+        // parked bit is kept while other threads stay parked
+        ParkingLot::unpark_one( &bits, [this]( ParkingLot::UnparkResult result ) noexcept -> intptr_t {
+            __atomic_store_n( &bits, result.have_more ? parked : 0, __ATOMIC_RELEASE );
+            return 0;
+        } );
+        return;
+    }
+}
@@ -4,18 +4,11 @@
 #include <sys/syscall.h>
 #include <linux/futex.h>
 #include <ctime>
+#include <cerrno>
 
 
 using namespace yarn;
 
-inline long
-yarn::_simple_futex( const uint32_t *uaddr,
-                     int futex_op,
-                     uint32_t val,
-                     const struct timespec *timeout ) {
-    return syscall( SYS_futex, uaddr, futex_op, val, timeout, nullptr, 0 );
-}
-
 static long
 time_diff_ns( struct timespec *now, struct timespec *before ) {
     return 1000000l * ( now->tv_sec - before->tv_sec - 1 ) + ( 1000000000l + now->tv_nsec - before->tv_nsec ) / 1000;
@@ -30,9 +23,6 @@ TimeoutExpiredException::TimeoutExpiredException( const char *msg )
 }
 
 
-Lock::Lock( uint32_t spinlock_time_ns ) noexcept
-    : spin_time( spinlock_time_ns ) {}
-
 void Lock::lock() noexcept {
     if( tryLock() )
         return;
@@ -40,23 +30,20 @@ void Lock::lock() noexcept {
     struct timespec start_time{};
     clock_gettime( CLOCK_MONOTONIC, &start_time );
 
+    // only read loop to decrease cache invalidation by CMPXCHG
+    // atomic swap does not execute unless lock value is observed as 0
     while( true ) {
-        // only read loop to decrease cache invalidation by CMPXCHG
-        // atomic swap does not execute unless lock value is observed as 0
-        while( true ) {
-            if( tryLock() )
-                return;
+        if( tryLock() )
+            return;
 
-            struct timespec now{};
-            clock_gettime( CLOCK_MONOTONIC, &now );
+        struct timespec now{};
+        clock_gettime( CLOCK_MONOTONIC, &now );
 
-            if( time_diff_ns( &now, &start_time) >= spin_time )
-                break;
-        }
-        __sync_add_and_fetch( &waiter_count, 1 );
-        _simple_futex( &lock_value, FUTEX_WAIT, 1 );
-        __sync_sub_and_fetch( &waiter_count, 1 );
+        if( time_diff_ns( &now, &start_time) >= spin_time )
+            break;
     }
+
+    lock_contended();
 }
 
 void Lock::lock( uint32_t timeout_ns ) {
@@ -66,131 +53,174 @@ void Lock::lock( uint32_t timeout_ns ) {
     struct timespec start_time{}, now{};
     clock_gettime( CLOCK_MONOTONIC, &start_time );
 
+    // only read loop to decrease cache invalidation by CMPXCHG
+    // atomic swap does not execute unless lock value is observed as 0
     while( true ) {
-        // only read loop to decrease cache invalidation by CMPXCHG
-        // atomic swap does not execute unless lock value is observed as 0
-        while( true ) {
-            if( tryLock() )
-                return;
+        if( tryLock() )
+            return;
 
-            clock_gettime( CLOCK_MONOTONIC, &now );
+        clock_gettime( CLOCK_MONOTONIC, &now );
 
-            if( time_diff_ns( &now, &start_time) >= std::min( spin_time, timeout_ns ) )
-                break;
-        }
+        if( time_diff_ns( &now, &start_time) >= std::min( spin_time, timeout_ns ) )
+            break;
+    }
 
+    // from now on lock is marked as contended, so that owner wakes us up on unlock
+    while( __sync_lock_test_and_set( &lock_value, 2 ) != 0 ) {
         long time_diff = time_diff_ns( &now, &start_time );
 
         if( time_diff >= timeout_ns )
             throw TimeoutExpiredException( "Timeout expired before lock was possible." );
 
         // time remaining for sleep
-        time_diff -= timeout_ns;
+        time_diff = timeout_ns - time_diff;
 
         // store back to now struct
-        now.tv_sec = time_diff / 1000000;
-        now.tv_nsec = ( time_diff % 1000000 ) * 1000;
+        struct timespec remaining{};
+        remaining.tv_sec = time_diff / 1000000;
+        remaining.tv_nsec = ( time_diff % 1000000 ) * 1000;
 
-        __sync_add_and_fetch( &waiter_count, 1 );
-        _simple_futex( &lock_value, FUTEX_WAIT, 1, &now );
-        __sync_sub_and_fetch( &waiter_count, 1 );
+        _simple_futex( &lock_value, FUTEX_WAIT, 2, &remaining );
 
-        // measure time if timeout expired
         clock_gettime( CLOCK_MONOTONIC, &now );
-        if( time_diff_ns( &now, &start_time ) >= timeout_ns )
-            throw TimeoutExpiredException( "Timeout expired before lock was possible." );
     }
 }
 
-[[nodiscard]] inline bool Lock::tryLock() noexcept {
+[[nodiscard]] bool Lock::tryLock() noexcept {
     return lock_value == 0 && __sync_bool_compare_and_swap( &lock_value, 0, 1 );
 }
 
 void Lock::unlock() noexcept {
-    lock_value = 0;
-    if( waiter_count )
-        _simple_futex( &lock_value, FUTEX_WAKE, 1 );
+    // 1 -> 0 means nobody was blocked, otherwise lock was contended
+    if( __sync_fetch_and_sub( &lock_value, 1 ) == 1 )
+        return;
+
+    __sync_lock_release( &lock_value );
+    _simple_futex( &lock_value, FUTEX_WAKE, 1 );
+}
+
+void Lock::lock_contended() noexcept {
+    while( __sync_lock_test_and_set( &lock_value, 2 ) != 0 )
+        _simple_futex( &lock_value, FUTEX_WAIT, 2 );
 }
 
 
 Semaphore::Semaphore( uint32_t initial_value, uint32_t spinlock_time_ns ) noexcept
-    : value( initial_value ), spin_time( spinlock_time_ns ) {}
+    : units( initial_value ), spin_time( spinlock_time_ns ) {}
 
 void Semaphore::take() noexcept {
-    if( tryTake() )
+    take_n( 1 );
+}
+
+void Semaphore::take( uint32_t timeout_ns ) {
+    take_n( 1, timeout_ns );
+}
+
+[[nodiscard]] bool Semaphore::tryTake() noexcept {
+    return tryTake( 1 );
+}
+
+void Semaphore::take_n( uint32_t count ) noexcept {
+    if( tryTake( count ) )
         return;
 
     struct timespec start_time{};
     clock_gettime( CLOCK_MONOTONIC, &start_time );
 
+    // only read loop to decrease cache invalidation by CMPXCHG
+    // atomic swap does not execute unless value is observed as high enough
     while( true ) {
-        // only read loop to decrease cache invalidation by CMPXCHG
-        // atomic swap does not execute unless lock value is observed as 0
-        while( true ) {
-            if( tryTake() )
-                return;
+        if( tryTake( count ) )
+            return;
+
+        struct timespec now{};
+        clock_gettime( CLOCK_MONOTONIC, &now );
 
-            struct timespec now{};
-            clock_gettime( CLOCK_MONOTONIC, &now );
+        if( time_diff_ns( &now, &start_time) >= spin_time )
+            break;
+    }
 
-            if( time_diff_ns( &now, &start_time) >= spin_time )
+    if( count > 1 )
+        __sync_add_and_fetch( &batch_waiters, 1 );
+
+    while( true ) {
+        uint32_t current = units;
+        if( current >= count ) {
+            if( __sync_bool_compare_and_swap( &units, current, current - count ) )
                 break;
+            continue;
         }
 
         __sync_add_and_fetch( &waiter_count, 1 );
-        _simple_futex( &value, FUTEX_WAIT, 0 );
+        _simple_futex( &units, FUTEX_WAIT, current );
         __sync_sub_and_fetch( &waiter_count, 1 );
     }
+
+    if( count > 1 )
+        __sync_sub_and_fetch( &batch_waiters, 1 );
 }
 
-void Semaphore::take( uint32_t timeout_ns ) {
-    if( tryTake() )
+void Semaphore::take_n( uint32_t count, uint32_t timeout_ns ) {
+    if( tryTake( count ) )
         return;
 
     struct timespec start_time{}, now{};
     clock_gettime( CLOCK_MONOTONIC, &start_time );
 
+    // only read loop to decrease cache invalidation by CMPXCHG
+    // atomic swap does not execute unless value is observed as high enough
     while( true ) {
-        // only read loop to decrease cache invalidation by CMPXCHG
-        // atomic swap does not execute unless lock value is observed as 0
-        while( true ) {
-            if( tryTake() )
-                return;
+        if( tryTake( count ) )
+            return;
 
-            clock_gettime( CLOCK_MONOTONIC, &now );
+        clock_gettime( CLOCK_MONOTONIC, &now );
 
-            if( time_diff_ns( &now, &start_time) >= std::min( spin_time, timeout_ns ) )
+        if( time_diff_ns( &now, &start_time) >= std::min( spin_time, timeout_ns ) )
+            break;
+    }
+
+    if( count > 1 )
+        __sync_add_and_fetch( &batch_waiters, 1 );
+
+    while( true ) {
+        uint32_t current = units;
+        if( current >= count ) {
+            if( __sync_bool_compare_and_swap( &units, current, current - count ) )
                 break;
+            continue;
         }
 
         long time_diff = time_diff_ns( &now, &start_time );
 
-        if( time_diff >= timeout_ns )
+        if( time_diff >= timeout_ns ) {
+            if( count > 1 )
+                __sync_sub_and_fetch( &batch_waiters, 1 );
             throw TimeoutExpiredException( "Timeout expired before take was possible." );
+        }
 
         // time remaining for sleep
-        time_diff -= timeout_ns;
+        time_diff = timeout_ns - time_diff;
 
-        // store back to now struct
-        now.tv_sec = time_diff / 1000000;
-        now.tv_nsec = ( time_diff % 1000000 ) * 1000;
+        struct timespec remaining{};
+        remaining.tv_sec = time_diff / 1000000;
+        remaining.tv_nsec = ( time_diff % 1000000 ) * 1000;
 
         __sync_add_and_fetch( &waiter_count, 1 );
-        _simple_futex( &value, FUTEX_WAIT, 0, &now );
+        _simple_futex( &units, FUTEX_WAIT, current, &remaining );
         __sync_sub_and_fetch( &waiter_count, 1 );
 
-        // measure time if timeout expired
         clock_gettime( CLOCK_MONOTONIC, &now );
-        if( time_diff_ns( &now, &start_time ) >= timeout_ns )
-            throw TimeoutExpiredException( "Timeout expired before take was possible." );
     }
+
+    if( count > 1 )
+        __sync_sub_and_fetch( &batch_waiters, 1 );
 }
 
-[[nodiscard]] bool Semaphore::tryTake() noexcept {
+[[nodiscard]] bool Semaphore::tryTake( uint32_t count ) noexcept {
     while( true ) {
-        uint32_t temp = value;
-        if( temp > 0 ) {
-            if( __sync_bool_compare_and_swap( &value, temp, temp - 1 ) )
+        uint32_t temp = units;
+        if( temp >= count ) {
+            if( __sync_bool_compare_and_swap( &units, temp, temp - count ) )
                 return true;
         }
         else return false;
@@ -198,30 +228,175 @@ void Semaphore::take( uint32_t timeout_ns ) {
 }
 
 void Semaphore::give() noexcept {
-    __sync_fetch_and_add( &value, 1 );
-    if( waiter_count )
-        _simple_futex( &value, FUTEX_WAKE, 1 );
+    give( 1 );
+}
+
+void Semaphore::give( uint32_t count ) noexcept {
+    if( count == 0 )
+        return;
+
+    __sync_fetch_and_add( &units, count );
+
+    uint32_t waiters = waiter_count;
+    if( !waiters )
+        return;
 
+    // waiter taking more units may not be chosen by kernel, so everybody re-checks
+    if( batch_waiters )
+        _simple_futex( &units, FUTEX_WAKE, INT32_MAX );
+    else _simple_futex( &units, FUTEX_WAKE, std::min( count, waiters ) );
 }
 
+[[nodiscard]] uint32_t Semaphore::value() const noexcept {
+    return __atomic_load_n( &units, __ATOMIC_ACQUIRE );
+}
+
+
+static constexpr uint64_t condition_granted = 1ull << 32;
+
+static inline uint32_t condition_pending( uint64_t state ) {
+    return static_cast<uint32_t>( state );
+}
+
+static inline uint32_t condition_granted_count( uint64_t state ) {
+    return static_cast<uint32_t>( state >> 32 );
+}
 
 void Condition::wait( Lock &lock ) noexcept {
-    uint32_t current = __sync_add_and_fetch( &waiters, 1 );
+    timed_wait( lock, nullptr );
+}
+
+void Condition::wait_until( Lock &lock, std::chrono::steady_clock::time_point deadline ) {
+    const struct timespec abs_deadline = _to_timespec( deadline );
+    if( !timed_wait( lock, &abs_deadline ) )
+        throw TimeoutExpiredException( "Timeout expired before condition was signaled." );
+}
+
+bool Condition::timed_wait( Lock &lock, const struct timespec *deadline ) noexcept {
+    associated_lock = &lock;
+    __sync_add_and_fetch( &waiter_state, 1 );
+    uint32_t current = sequence;
 
     lock.unlock();
 
-    _simple_futex( &waiters, FUTEX_WAIT, current );
-    __sync_sub_and_fetch( &waiters, 1 );
+    bool signaled = true;
+    while( true ) {
+        long status = _deadline_futex( &sequence, current, deadline );
+        bool expired = status == -1 && errno == ETIMEDOUT;
+        current = sequence;
 
-    lock.lock();
+        if( consume_signal() )
+            break;
+
+        if( !expired )
+            continue;
+
+        // signal can grant wake-up until we leave, so leaving and consuming it is single step
+        signaled = withdraw();
+        break;
+    }
+
+    // we may have been requeued to lock, so we must pass wake-up to next one
+    lock.lock_contended();
+    return signaled;
+}
+
+bool Condition::consume_signal() noexcept {
+    while( true ) {
+        uint64_t state = waiter_state;
+        if( condition_granted_count( state ) == 0 )
+            return false;
+        if( __sync_bool_compare_and_swap( &waiter_state, state, state - condition_granted ) )
+            return true;
+    }
+}
+
+bool Condition::withdraw() noexcept {
+    while( true ) {
+        uint64_t state = waiter_state;
+        // granted wake-up is taken before pending slot, otherwise slot of newer waiter could be taken
+        // while wake-up stays granted and nobody consumes it
+        bool granted = condition_granted_count( state ) != 0;
+        uint64_t desired = granted ? state - condition_granted : state - 1;
+        if( __sync_bool_compare_and_swap( &waiter_state, state, desired ) )
+            return granted;
+    }
 }
 
 void Condition::signal() noexcept {
-    _simple_futex(&waiters, FUTEX_WAKE, 1);
+    while( true ) {
+        uint64_t state = waiter_state;
+        if( condition_pending( state ) == 0 )
+            return;
+        if( __sync_bool_compare_and_swap( &waiter_state, state, state - 1 + condition_granted ) )
+            break;
+    }
+
+    __sync_add_and_fetch( &sequence, 1 );
+    _simple_futex( &sequence, FUTEX_WAKE, 1 );
 }
 
 void Condition::signal_all() noexcept {
-    _simple_futex(&waiters, FUTEX_WAKE, INT32_MAX);
+    while( true ) {
+        uint64_t state = waiter_state;
+        uint64_t pending = condition_pending( state );
+        if( pending == 0 )
+            return;
+        if( __sync_bool_compare_and_swap( &waiter_state, state, state - pending + pending * condition_granted ) )
+            break;
+    }
+
+    uint32_t current = __sync_add_and_fetch( &sequence, 1 );
+    Lock *lock = associated_lock;
+
+    // wake up one waiter, move the rest to lock, woken up waiter will pass the wake-up along on unlock
+    while( _requeue_futex( &sequence, 1, INT32_MAX, &lock->lock_value, current ) == -1 && errno == EAGAIN )
+        current = sequence;
+}
+
+void Condition::wait( Lock &lock, uint32_t mask ) noexcept {
+    __sync_add_and_fetch( &class_waiters, 1 );
+    uint32_t current = class_sequence;
+
+    lock.unlock();
+
+    _deadline_futex( &class_sequence, current, nullptr, mask );
+    __sync_sub_and_fetch( &class_waiters, 1 );
+
+    lock.lock();
+}
+
+void Condition::signal( uint32_t mask ) noexcept {
+    if( class_waiters == 0 )
+        return;
+
+    __sync_add_and_fetch( &class_sequence, 1 );
+    _wake_bitset_futex( &class_sequence, 1, mask );
+}
+
+void Condition::signal_all( uint32_t mask ) noexcept {
+    if( class_waiters == 0 )
+        return;
+
+    __sync_add_and_fetch( &class_sequence, 1 );
+    _wake_bitset_futex( &class_sequence, INT32_MAX, mask );
+}
+
+void Condition::signal_and_unlock( Lock &lock ) noexcept {
+    while( true ) {
+        uint64_t state = waiter_state;
+        if( condition_pending( state ) == 0 ) {
+            lock.unlock();
+            return;
+        }
+        if( __sync_bool_compare_and_swap( &waiter_state, state, state - 1 + condition_granted ) )
+            break;
+    }
+
+    __sync_add_and_fetch( &sequence, 1 );
+
+    // lock_value = 0; wake one waiter on sequence; if lock was contended( > 1 ) wake one waiter on lock
+    _wake_op_futex( &sequence, 1, 1, &lock.lock_value, FUTEX_OP( FUTEX_OP_SET, 0, FUTEX_OP_CMP_GT, 1 ) );
 }
 
 
@@ -232,24 +407,21 @@ void Monitor::lock() noexcept {
     struct timespec start_time{};
     clock_gettime( CLOCK_MONOTONIC, &start_time );
 
+    // only read loop to decrease cache invalidation by CMPXCHG
+    // atomic swap does not execute unless lock value is observed as 0
     while( true ) {
-        // only read loop to decrease cache invalidation by CMPXCHG
-        // atomic swap does not execute unless lock value is observed as 0
-        while( true ) {
-            if( tryLock() )
-                return;
-
-            struct timespec now{};
-            clock_gettime( CLOCK_MONOTONIC, &now );
+        if( tryLock() )
+            return;
 
-            if( time_diff_ns( &now, &start_time) >= spin_time )
-                break;
-        }
+        struct timespec now{};
+        clock_gettime( CLOCK_MONOTONIC, &now );
 
-        __sync_add_and_fetch( &lock_waiters, 1 );
-        _simple_futex( &monitor_lock, FUTEX_WAIT, 1 );
-        __sync_sub_and_fetch( &lock_waiters, 1 );
+        if( time_diff_ns( &now, &start_time) >= spin_time )
+            break;
     }
+
+    while( __sync_lock_test_and_set( &monitor_lock, 2 ) != 0 )
+        _simple_futex( &monitor_lock, FUTEX_WAIT, 2 );
 }
 
 [[nodiscard]] bool Monitor::tryLock() noexcept {
@@ -258,29 +430,312 @@ void Monitor::lock() noexcept {
 
 
 void Monitor::signal_all() noexcept {
-    for( auto &waiter: waiters ) {
-        waiter.predicate = [](){ return true; };
-    }
+    for( LockNode *head: heads )
+        for( LockNode *waiter = head; waiter != nullptr; waiter = waiter->next ) {
+            waiter->released = true;
+            mark_stale( *waiter );
+        }
+}
+
+void Monitor::notify( uint32_t key ) noexcept {
+    notified |= 1u << ( key % key_buckets );
+}
+
+void Monitor::unlock( uint32_t key ) noexcept {
+    notify( key );
+    unlock();
 }
 
 void Monitor::unlock() noexcept {
-    for( auto &waiter: waiters ) {
-        if( !waiter.predicate() )
+    LockNode *waiter = hand_over( 1 );
+    if( waiter == nullptr ) {
+        silent_unlock();
+        return;
+    }
+
+    _simple_futex( &waiter->lock, FUTEX_WAKE, 1 );
+}
+
+void Monitor::silent_unlock() noexcept {
+    // 1 -> 0 means nobody was blocked, otherwise lock was contended
+    if( __sync_fetch_and_sub( &monitor_lock, 1 ) == 1 )
+        return;
+
+    __sync_lock_release( &monitor_lock );
+    _simple_futex( &monitor_lock, FUTEX_WAKE, 1 );
+}
+
+void Monitor::signal_and_unlock() noexcept {
+    LockNode *waiter = hand_over( 2 );
+    if( waiter == nullptr ) {
+        silent_unlock();
+        return;
+    }
+
+    // monitor_lock = 0; wake waiter; if monitor was contended( > 1 ) wake one thread blocked in lock
+    _wake_op_futex( &waiter->lock, 1, 1, &monitor_lock, FUTEX_OP( FUTEX_OP_SET, 0, FUTEX_OP_CMP_GT, 1 ) );
+}
+
+Monitor::LockNode *Monitor::hand_over( uint32_t state ) noexcept {
+    const uint32_t keys = notified;
+    while( true ) {
+        LockNode *waiter = find_ready();
+        if( waiter == nullptr )
+            return nullptr;
+
+        // waiter can time out or be cancelled after evaluation, then it acquires monitor itself
+        if( __sync_bool_compare_and_swap( &waiter->lock, 0, state ) )
+            return waiter;
+
+        // search again among same waiters, cancelled one is skipped now
+        notified = keys;
+    }
+}
+
+bool Monitor::wait( LockNode &node, const struct timespec *deadline ) noexcept {
+    node.ticket = next_ticket++;
+    link( node );
+
+    while( true ) {
+        if( evaluate( node ) ) {
+            remove( node );
+            return true;
+        }
+
+        // cancelled while we own monitor
+        if( node.lock == 3 ) {
+            remove( node );
+            return false;
+        }
+
+        unlock();
+
+        bool expired = false;
+        while( node.lock == 0 && !expired )
+            expired = _deadline_futex( &node.lock, 0, deadline ) == -1 && errno == ETIMEDOUT;
+
+        // withdraw from candidates, unless monitor was handed over meanwhile
+        if( expired )
+            __sync_bool_compare_and_swap( &node.lock, 0, 3 );
+
+        // monitor was handed over to us
+        if( node.lock == 1 ) {
+            remove( node );
+            return true;
+        }
+
+        // woken up by signal_and_unlock, timed out or cancelled, we must acquire monitor ourselves
+        lock();
+
+        if( __sync_bool_compare_and_swap( &node.lock, 2, 0 ) )
             continue;
 
-        waiter.lock = 1;
-        _simple_futex( &waiter.lock, FUTEX_WAKE, 1 );
+        // only own predicate is checked, no other waiter is evaluated
+        bool result = evaluate( node );
+        remove( node );
+        return result;
+    }
+}
+
+void Monitor::cancel( LockNode &node ) noexcept {
+    while( true ) {
+        uint32_t state = node.lock;
+        if( state != 0 && state != 2 )
+            return;
+
+        if( __sync_bool_compare_and_swap( &node.lock, state, 3 ) ) {
+            _simple_futex( &node.lock, FUTEX_WAKE, 1 );
+            return;
+        }
+    }
+}
+
+void Monitor::link( LockNode &node ) noexcept {
+    const uint32_t list = node.tracked ? tracked_list : node.bucket;
+    LockNode *&head = heads[ list ], *&tail = tails[ list ];
 
+    // keep buckets sorted by arrival, node can come back to bucket from tracked list
+    LockNode *prev = tail;
+    if( !node.tracked )
+        while( prev != nullptr && static_cast<int32_t>( prev->ticket - node.ticket ) > 0 )
+            prev = prev->prev;
+
+    node.prev = prev;
+    node.next = prev != nullptr ? prev->next : head;
+
+    if( node.prev != nullptr )
+        node.prev->next = &node;
+    else head = &node;
+
+    if( node.next != nullptr )
+        node.next->prev = &node;
+    else tail = &node;
+}
+
+void Monitor::unlink( LockNode &node ) noexcept {
+    const uint32_t list = node.tracked ? tracked_list : node.bucket;
+    LockNode *&head = heads[ list ], *&tail = tails[ list ];
+
+    if( node.prev != nullptr )
+        node.prev->next = node.next;
+    else head = node.next;
+
+    if( node.next != nullptr )
+        node.next->prev = node.prev;
+    else tail = node.prev;
+}
+
+void Monitor::remove( LockNode &node ) noexcept {
+    unlink( node );
+    clear_stale( node );
+    release_dependencies( node );
+}
+
+bool Monitor::evaluate( LockNode &node ) noexcept {
+    // released waiter stays candidate until it is served
+    if( node.released ) {
+        mark_stale( node );
+        return true;
+    }
+
+    release_dependencies( node );
+    node.overflow = false;
+
+    evaluating = &node;
+    bool result = node.predicate();
+    evaluating = nullptr;
+
+    bool tracked = node.dependency_count != 0 && !node.overflow;
+    if( tracked != node.tracked ) {
+        unlink( node );
+        node.tracked = tracked;
+        link( node );
+        if( !tracked )
+            release_dependencies( node );
+    }
+
+    // satisfied tracked waiter stays candidate until it is served
+    if( result && tracked )
+        mark_stale( node );
+    else clear_stale( node );
+
+    return result;
+}
+
+void Monitor::release_dependencies( LockNode &node ) noexcept {
+    for( uint32_t i = 0; i < node.dependency_count; i++ ) {
+        Dependency &dependency = node.dependencies[ i ];
+        if( dependency.prev != nullptr )
+            dependency.prev->next = dependency.next;
+        else dependency.cell->dependents = dependency.next;
+
+        if( dependency.next != nullptr )
+            dependency.next->prev = dependency.prev;
+    }
+    node.dependency_count = 0;
+}
+
+void Monitor::mark_stale( LockNode &node ) noexcept {
+    if( node.stale )
+        return;
+
+    node.stale = true;
+    node.stale_prev = nullptr;
+    node.stale_next = stale_head;
+    if( stale_head != nullptr )
+        stale_head->stale_prev = &node;
+    stale_head = &node;
+}
+
+void Monitor::clear_stale( LockNode &node ) noexcept {
+    if( !node.stale )
+        return;
+
+    node.stale = false;
+    if( node.stale_prev != nullptr )
+        node.stale_prev->stale_next = node.stale_next;
+    else stale_head = node.stale_next;
+
+    if( node.stale_next != nullptr )
+        node.stale_next->stale_prev = node.stale_prev;
+}
+
+void Monitor::record( CellBase &cell ) noexcept {
+    LockNode *node = evaluating;
+    if( node == nullptr )
+        return;
+
+    for( uint32_t i = 0; i < node->dependency_count; i++ )
+        if( node->dependencies[ i ].cell == &cell )
+            return;
+
+    if( node->dependency_count == max_dependencies ) {
+        node->overflow = true;
         return;
     }
 
-    silent_unlock();
+    Dependency &dependency = node->dependencies[ node->dependency_count++ ];
+    dependency.cell = &cell;
+    dependency.node = node;
+    dependency.version = cell.cell_version;
+    dependency.prev = nullptr;
+    dependency.next = cell.dependents;
+    if( cell.dependents != nullptr )
+        cell.dependents->prev = &dependency;
+    cell.dependents = &dependency;
 }
 
-void Monitor::silent_unlock() noexcept {
-    monitor_lock = 0;
-    if( lock_waiters )
-        _simple_futex( &monitor_lock, FUTEX_WAKE, 1 );
+void Monitor::touch( CellBase &cell ) noexcept {
+    ++cell.cell_version;
+    if( cell.dirty )
+        return;
 
+    cell.dirty = true;
+    cell.next_dirty = dirty;
+    dirty = &cell;
 }
 
+Monitor::LockNode *Monitor::find_ready() noexcept {
+    // waiters that read cells written in this critical section must be reevaluated
+    for( CellBase *cell = dirty; cell != nullptr; cell = cell->next_dirty ) {
+        cell->dirty = false;
+        for( Dependency *dependency = cell->dependents; dependency != nullptr; dependency = dependency->next )
+            if( dependency->version != cell->cell_version )
+                mark_stale( *dependency->node );
+    }
+    dirty = nullptr;
+
+    LockNode *ready = nullptr;
+    for( LockNode *waiter = stale_head, *next; waiter != nullptr; waiter = next ) {
+        next = waiter->stale_next;
+
+        if( waiter->lock != 0 ) {
+            clear_stale( *waiter );
+            continue;
+        }
+
+        if( evaluate( *waiter ) && ( ready == nullptr || static_cast<int32_t>( waiter->ticket - ready->ticket ) < 0 ) )
+            ready = waiter;
+    }
+
+    // waiters without key are always evaluated
+    uint64_t buckets = notified | ( 1ull << key_buckets );
+    notified = 0;
+
+    for( ; buckets != 0; buckets &= buckets - 1 ) {
+        for( LockNode *waiter = heads[ __builtin_ctzll( buckets ) ], *next; waiter != nullptr; waiter = next ) {
+            // only older waiter than already found one can be served first
+            if( ready != nullptr && static_cast<int32_t>( waiter->ticket - ready->ticket ) > 0 )
+                break;
+
+            next = waiter->next;
+            if( waiter->lock == 0 && evaluate( *waiter ) ) {
+                if( ready == nullptr || static_cast<int32_t>( waiter->ticket - ready->ticket ) < 0 )
+                    ready = waiter;
+                break;
+            }
+        }
+    }
+
+    return ready;
+}
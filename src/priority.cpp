@@ -0,0 +1,172 @@
+#include "priority.hpp"
+
+#include <ctime>
+
+
+using namespace yarn;
+
+static uint64_t
+now_us() {
+    struct timespec now{};
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return static_cast<uint64_t>( now.tv_sec ) * 1000000 + now.tv_nsec / 1000;
+}
+
+
+PriorityWaiters::PriorityWaiters( uint32_t aging_us ) noexcept
+    : aging( aging_us ) {}
+
+void PriorityWaiters::push( Node &node, uint32_t priority ) noexcept {
+    node.priority = priority < levels ? priority : levels - 1;
+    if( aging != 0 )
+        node.arrival_us = now_us();
+
+    Node *&tail = tails[ node.priority ];
+    node.prev = tail;
+    node.next = nullptr;
+    if( tail != nullptr )
+        tail->next = &node;
+    else heads[ node.priority ] = &node;
+    tail = &node;
+
+    non_empty |= 1u << node.priority;
+}
+
+void PriorityWaiters::erase( Node &node ) noexcept {
+    if( node.prev != nullptr )
+        node.prev->next = node.next;
+    else heads[ node.priority ] = node.next;
+
+    if( node.next != nullptr )
+        node.next->prev = node.prev;
+    else tails[ node.priority ] = node.prev;
+
+    if( heads[ node.priority ] == nullptr )
+        non_empty &= ~( 1u << node.priority );
+}
+
+void PriorityWaiters::age() noexcept {
+    if( aging == 0 || non_empty == 0 )
+        return;
+
+    const uint64_t now = now_us();
+
+    // levels are FIFO, so only heads can be old enough; top level can not go higher
+    for( uint32_t level = 0; level + 1 < levels; level++ ) {
+        Node *head;
+        while( ( head = heads[ level ] ) != nullptr && now >= head->arrival_us + aging ) {
+            erase( *head );
+            push( *head, level + 1 );
+        }
+    }
+}
+
+[[nodiscard]] PriorityWaiters::Node *PriorityWaiters::top() const noexcept {
+    if( non_empty == 0 )
+        return nullptr;
+
+    return heads[ 31 - __builtin_clz( non_empty ) ];
+}
+
+[[nodiscard]] PriorityWaiters::Node *PriorityWaiters::next( const Node &node ) const noexcept {
+    if( node.next != nullptr )
+        return node.next;
+
+    uint32_t lower = non_empty & ( ( 1u << node.priority ) - 1 );
+    if( lower == 0 )
+        return nullptr;
+
+    return heads[ 31 - __builtin_clz( lower ) ];
+}
+
+
+PriorityCondition::PriorityCondition( uint32_t aging_us ) noexcept
+    : waiters( aging_us ) {}
+
+void PriorityCondition::wait( Lock &lock, uint32_t priority ) noexcept {
+    PriorityWaiters::Node node{};
+
+    queue_lock.lock();
+    waiters.push( node, priority );
+    queue_lock.unlock();
+
+    lock.unlock();
+
+    // signal sent before we block changes state, so it can not be lost
+    while( node.state == 0 )
+        _simple_futex( &node.state, FUTEX_WAIT, 0 );
+
+    lock.lock();
+}
+
+void PriorityCondition::signal() noexcept {
+    if( waiters.empty() )
+        return;
+
+    queue_lock.lock();
+    waiters.age();
+    PriorityWaiters::Node *node = waiters.top();
+    if( node == nullptr ) {
+        queue_lock.unlock();
+        return;
+    }
+    waiters.erase( *node );
+
+    node->state = 1;
+    queue_lock.unlock();
+    _simple_futex( &node->state, FUTEX_WAKE, 1 );
+}
+
+void PriorityCondition::signal_all() noexcept {
+    if( waiters.empty() )
+        return;
+
+    queue_lock.lock();
+    while( PriorityWaiters::Node *node = waiters.top() ) {
+        waiters.erase( *node );
+        node->state = 1;
+        _simple_futex( &node->state, FUTEX_WAKE, 1 );
+    }
+    queue_lock.unlock();
+}
+
+
+PriorityMonitor::PriorityMonitor( uint32_t aging_us ) noexcept
+    : waiters( aging_us ) {}
+
+void PriorityMonitor::lock() noexcept {
+    entry.lock();
+}
+
+[[nodiscard]] bool PriorityMonitor::tryLock() noexcept {
+    return entry.tryLock();
+}
+
+void PriorityMonitor::unlock() noexcept {
+    waiters.age();
+
+    for( PriorityWaiters::Node *node = waiters.top(); node != nullptr; node = waiters.next( *node ) ) {
+        if( !( *node->predicate )() )
+            continue;
+
+        // monitor stays locked, ownership is handed over
+        waiters.erase( *node );
+        node->state = 1;
+        _simple_futex( &node->state, FUTEX_WAKE, 1 );
+        return;
+    }
+
+    silent_unlock();
+}
+
+void PriorityMonitor::silent_unlock() noexcept {
+    entry.unlock();
+}
+
+void PriorityMonitor::wait( PriorityWaiters::Node &node, uint32_t priority ) noexcept {
+    waiters.push( node, priority );
+    unlock();
+
+    while( node.state == 0 )
+        _simple_futex( &node.state, FUTEX_WAIT, 0 );
+}
@@ -0,0 +1,91 @@
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <stdexcept>
+
+
+using namespace yarn;
+
+static uint64_t
+now_ns() {
+    struct timespec now{};
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return static_cast<uint64_t>( now.tv_sec ) * 1000000000 + now.tv_nsec;
+}
+
+
+static uint64_t
+saturating_add( uint64_t a, uint64_t b ) {
+    uint64_t result;
+    return __builtin_add_overflow( a, b, &result ) ? UINT64_MAX : result;
+}
+
+static uint64_t
+saturating_mul( uint64_t a, uint64_t b ) {
+    uint64_t result;
+    return __builtin_mul_overflow( a, b, &result ) ? UINT64_MAX : result;
+}
+
+
+RateLimiter::RateLimiter( double rate, uint32_t burst ) {
+    // negated comparison rejects NaN as well
+    if( !( rate > 0 ) || !std::isfinite( rate ) )
+        throw std::invalid_argument( "Rate must be positive and finite." );
+
+    // interval must be representable, 2^63 ns is almost 300 years per token
+    const double nanoseconds = 1e9 / rate;
+    if( nanoseconds >= 0x1p63 )
+        throw std::invalid_argument( "Rate is too small." );
+
+    interval = std::max<uint64_t>( static_cast<uint64_t>( std::llround( nanoseconds ) ), 1 );
+    if( __builtin_mul_overflow( interval, static_cast<uint64_t>( burst ), &tolerance ) )
+        throw std::invalid_argument( "Refilling whole burst does not fit into 64-bit ns." );
+}
+
+void RateLimiter::acquire( uint32_t count ) noexcept {
+    uint64_t ready = reserve( count, now_ns(), UINT64_MAX );
+    park( ready );
+}
+
+void RateLimiter::acquire_until( uint32_t count, std::chrono::steady_clock::time_point deadline ) {
+    const struct timespec abs_deadline = _to_timespec( deadline );
+    uint64_t latest = static_cast<uint64_t>( abs_deadline.tv_sec ) * 1000000000 + abs_deadline.tv_nsec;
+
+    uint64_t ready = reserve( count, now_ns(), latest );
+    if( ready == 0 )
+        throw TimeoutExpiredException( "Timeout expired before tokens were refilled." );
+    park( ready );
+}
+
+[[nodiscard]] bool RateLimiter::tryAcquire( uint32_t count ) noexcept {
+    uint64_t now = now_ns();
+    return reserve( count, now, now ) != 0;
+}
+
+uint64_t RateLimiter::reserve( uint32_t count, uint64_t now, uint64_t latest ) noexcept {
+    while( true ) {
+        uint64_t current = full_at;
+
+        // lazy refill: bucket that was full in past is simply full now
+        // saturated time is never reached, such request is refused or parks forever
+        uint64_t next = saturating_add( std::max( current, now ), saturating_mul( interval, count ) );
+        uint64_t ready = next > tolerance ? std::max( next - tolerance, now ) : now;
+
+        if( ready > latest )
+            return 0;
+
+        if( __sync_bool_compare_and_swap( &full_at, current, next ) )
+            return ready;
+    }
+}
+
+void RateLimiter::park( uint64_t ready ) noexcept {
+    const struct timespec abs_ready = { static_cast<time_t>( ready / 1000000000 ),
+                                        static_cast<long>( ready % 1000000000 ) };
+
+    // nobody wakes parking word, waiter returns on timeout; spurious wake-ups are checked against clock
+    while( now_ns() < ready )
+        _deadline_futex( &parking, 0, &abs_ready );
+}
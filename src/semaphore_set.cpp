@@ -0,0 +1,79 @@
+#include "semaphore_set.hpp"
+
+#include <stdexcept>
+
+
+using namespace yarn;
+
+SemaphoreSet::SemaphoreSet( std::vector<uint32_t> initial_values )
+    : values( std::move( initial_values ) ) {}
+
+void SemaphoreSet::take( const std::vector<Operation> &operations ) {
+    check( operations );
+    lock.lock();
+    released.wait( lock, classes( operations ), [&]() noexcept { return take_locked( operations ); } );
+    lock.unlock();
+}
+
+[[nodiscard]] bool SemaphoreSet::tryTake( const std::vector<Operation> &operations ) {
+    check( operations );
+    lock.lock();
+    bool taken = take_locked( operations );
+    lock.unlock();
+
+    return taken;
+}
+
+void SemaphoreSet::give( const std::vector<Operation> &operations ) {
+    check( operations );
+    lock.lock();
+    for( const Operation &operation: operations )
+        values[ operation.semaphore ] += operation.count;
+    released.signal_all( classes( operations ) );
+    lock.unlock();
+}
+
+[[nodiscard]] uint32_t SemaphoreSet::value( uint32_t semaphore ) {
+    if( semaphore >= values.size() )
+        throw std::out_of_range( "Semaphore index is out of set." );
+
+    lock.lock();
+    uint32_t current = values[ semaphore ];
+    lock.unlock();
+
+    return current;
+}
+
+void SemaphoreSet::check( const std::vector<Operation> &operations ) const {
+    // size of set never changes, so no lock is needed
+    for( const Operation &operation: operations )
+        if( operation.semaphore >= values.size() )
+            throw std::out_of_range( "Semaphore index is out of set." );
+}
+
+bool SemaphoreSet::take_locked( const std::vector<Operation> &operations ) noexcept {
+    // subtract one by one, so repeated semaphore is checked against remaining value
+    size_t taken = 0;
+    for( ; taken < operations.size(); taken++ ) {
+        const Operation &operation = operations[ taken ];
+        if( values[ operation.semaphore ] < operation.count )
+            break;
+        values[ operation.semaphore ] -= operation.count;
+    }
+
+    if( taken == operations.size() )
+        return true;
+
+    while( taken-- > 0 )
+        values[ operations[ taken ].semaphore ] += operations[ taken ].count;
+    return false;
+}
+
+uint32_t SemaphoreSet::classes( const std::vector<Operation> &operations ) noexcept {
+    uint32_t mask = 0;
+    for( const Operation &operation: operations )
+        mask |= 1u << ( operation.semaphore % 32 );
+
+    // empty take is satisfied immediately, mask just must not be 0
+    return mask != 0 ? mask : 1;
+}
@@ -0,0 +1,107 @@
+#include "sharded_semaphore.hpp"
+
+#include <sched.h>
+
+
+using namespace yarn;
+
+ShardedSemaphore::ShardedSemaphore( uint32_t initial_value, uint32_t shard_count )
+    : shard_count( shard_count ) {
+    if( this->shard_count == 0 ) {
+        long cpus = sysconf( _SC_NPROCESSORS_CONF );
+        this->shard_count = cpus > 0 ? static_cast<uint32_t>( cpus ) : 1;
+    }
+
+    shards = std::make_unique<Shard[]>( this->shard_count );
+    for( uint32_t i = 0; i < this->shard_count; i++ )
+        shards[ i ].value = initial_value / this->shard_count + ( i < initial_value % this->shard_count ? 1 : 0 );
+}
+
+void ShardedSemaphore::take() noexcept {
+    while( true ) {
+        if( tryTake() )
+            return;
+
+        // announce ourselves before last check, so giver either sees us or we see its unit
+        __sync_add_and_fetch( &sleepers, 1 );
+        uint32_t current = generation;
+
+        if( tryTake() ) {
+            __sync_sub_and_fetch( &sleepers, 1 );
+            return;
+        }
+
+        _simple_futex( &generation, FUTEX_WAIT, current );
+        __sync_sub_and_fetch( &sleepers, 1 );
+    }
+}
+
+[[nodiscard]] bool ShardedSemaphore::tryTake() noexcept {
+    Shard &home = local();
+    while( true ) {
+        uint32_t temp = home.value;
+        if( temp == 0 )
+            break;
+        if( __sync_bool_compare_and_swap( &home.value, temp, temp - 1 ) )
+            return true;
+    }
+
+    return steal( home );
+}
+
+void ShardedSemaphore::give() noexcept {
+    give( 1 );
+}
+
+void ShardedSemaphore::give( uint32_t count ) noexcept {
+    if( count != 0 )
+        publish( local(), count );
+}
+
+[[nodiscard]] uint32_t ShardedSemaphore::available() const noexcept {
+    uint32_t sum = 0;
+    for( uint32_t i = 0; i < shard_count; i++ )
+        sum += shards[ i ].value;
+    return sum;
+}
+
+ShardedSemaphore::Shard &ShardedSemaphore::local() noexcept {
+    int cpu = sched_getcpu();
+    if( cpu < 0 )
+        cpu = 0;
+    return shards[ static_cast<uint32_t>( cpu ) % shard_count ];
+}
+
+bool ShardedSemaphore::steal( Shard &home ) noexcept {
+    uint32_t start = static_cast<uint32_t>( &home - shards.get() );
+    for( uint32_t i = 1; i < shard_count; i++ ) {
+        Shard &victim = shards[ ( start + i ) % shard_count ];
+
+        while( true ) {
+            uint32_t temp = victim.value;
+            if( temp == 0 )
+                break;
+
+            uint32_t grab = ( temp + 1 ) / 2;
+            if( !__sync_bool_compare_and_swap( &victim.value, temp, temp - grab ) )
+                continue;
+
+            // units in transit are invisible to other takers, so they are published like give
+            if( grab > 1 )
+                publish( home, grab - 1 );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ShardedSemaphore::publish( Shard &shard, uint32_t count ) noexcept {
+    __sync_fetch_and_add( &shard.value, count );
+
+    if( sleepers == 0 )
+        return;
+
+    __sync_fetch_and_add( &generation, 1 );
+    _simple_futex( &generation, FUTEX_WAKE, count );
+}
@@ -0,0 +1,82 @@
+#include "shared_monitor.hpp"
+
+
+using namespace yarn;
+
+void SharedMonitor::lock() noexcept {
+    Monitor::lock();
+    drain();
+}
+
+[[nodiscard]] bool SharedMonitor::tryLock() noexcept {
+    if( !Monitor::tryLock() )
+        return false;
+
+    if( __atomic_load_n( &readers, __ATOMIC_SEQ_CST ) == 0 )
+        return true;
+
+    Monitor::silent_unlock();
+    return false;
+}
+
+void SharedMonitor::lock_shared() noexcept {
+    if( tryLockShared() )
+        return;
+
+    // monitor is owned, shared entry queues for it like exclusive one and joins owners without draining
+    Monitor::lock();
+    __sync_add_and_fetch( &readers, 1 );
+    Monitor::silent_unlock();
+}
+
+[[nodiscard]] bool SharedMonitor::tryLockShared() noexcept {
+    // full barrier pairs with acquisition of monitor; either owner sees us in drain or we see it
+    __sync_add_and_fetch( &readers, 1 );
+    if( !owned() )
+        return true;
+
+    unlock_shared();
+    return false;
+}
+
+void SharedMonitor::unlock_shared() noexcept {
+    if( __sync_sub_and_fetch( &readers, 1 ) == 0 && __atomic_load_n( &draining, __ATOMIC_SEQ_CST ) )
+        _simple_futex( &readers, FUTEX_WAKE, 1 );
+}
+
+bool SharedMonitor::wait_exclusive( LockNode &node, const struct timespec *deadline ) noexcept {
+    bool result = wait( node, deadline );
+
+    // monitor may have been handed over by shared waiter, while other shared owners are inside
+    drain();
+    return result;
+}
+
+void SharedMonitor::wait_shared( LockNode &node ) noexcept {
+    // shared ownership is left before monitor is acquired, its owner may be draining
+    unlock_shared();
+    Monitor::lock();
+
+    wait( node );
+
+    __sync_add_and_fetch( &readers, 1 );
+    // other satisfied waiters are served one after another
+    Monitor::unlock();
+}
+
+void SharedMonitor::drain() noexcept {
+    while( true ) {
+        uint32_t current = __atomic_load_n( &readers, __ATOMIC_SEQ_CST );
+        if( current == 0 )
+            break;
+
+        __atomic_store_n( &draining, 1, __ATOMIC_SEQ_CST );
+        current = __atomic_load_n( &readers, __ATOMIC_SEQ_CST );
+        if( current == 0 )
+            break;
+
+        _simple_futex( &readers, FUTEX_WAIT, current );
+    }
+
+    __atomic_store_n( &draining, 0, __ATOMIC_RELAXED );
+}
@@ -0,0 +1,235 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+
+using namespace yarn;
+
+thread_local ThreadPool *ThreadPool::current_pool = nullptr;
+thread_local ThreadPool::Worker *ThreadPool::current_worker = nullptr;
+
+static uint32_t
+next_random( uint32_t &seed ) {
+    // xorshift32, seed must not be 0
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+
+WorkStealingDeque::WorkStealingDeque( uint32_t capacity )
+    : buffer( new Buffer{ capacity - 1, new Task *[ capacity ], nullptr } ) {}
+
+WorkStealingDeque::~WorkStealingDeque() {
+    while( buffer != nullptr ) {
+        Buffer *previous = buffer->previous;
+        delete[] buffer->slots;
+        delete buffer;
+        buffer = previous;
+    }
+}
+
+void WorkStealingDeque::push( Task *task ) {
+    int64_t b = __atomic_load_n( &bottom, __ATOMIC_RELAXED );
+    int64_t t = __atomic_load_n( &top, __ATOMIC_ACQUIRE );
+    Buffer *current = __atomic_load_n( &buffer, __ATOMIC_RELAXED );
+
+    if( b - t > current->mask ) {
+        current = grow( current, t, b );
+        __atomic_store_n( &buffer, current, __ATOMIC_RELEASE );
+    }
+
+    __atomic_store_n( &current->slots[ b & current->mask ], task, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    __atomic_store_n( &bottom, b + 1, __ATOMIC_RELAXED );
+}
+
+Task *WorkStealingDeque::pop() noexcept {
+    int64_t b = __atomic_load_n( &bottom, __ATOMIC_RELAXED ) - 1;
+    Buffer *current = __atomic_load_n( &buffer, __ATOMIC_RELAXED );
+    __atomic_store_n( &bottom, b, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    int64_t t = __atomic_load_n( &top, __ATOMIC_RELAXED );
+
+    if( t > b ) {
+        // deque was empty
+        __atomic_store_n( &bottom, b + 1, __ATOMIC_RELAXED );
+        return nullptr;
+    }
+
+    Task *task = __atomic_load_n( &current->slots[ b & current->mask ], __ATOMIC_RELAXED );
+    if( t == b ) {
+        // last task, race with thieves
+        if( !__atomic_compare_exchange_n( &top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) )
+            task = nullptr;
+        __atomic_store_n( &bottom, b + 1, __ATOMIC_RELAXED );
+    }
+    return task;
+}
+
+Task *WorkStealingDeque::steal() noexcept {
+    while( true ) {
+        int64_t t = __atomic_load_n( &top, __ATOMIC_ACQUIRE );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+        int64_t b = __atomic_load_n( &bottom, __ATOMIC_ACQUIRE );
+
+        if( t >= b )
+            return nullptr;
+
+        Buffer *current = __atomic_load_n( &buffer, __ATOMIC_ACQUIRE );
+        Task *task = __atomic_load_n( &current->slots[ t & current->mask ], __ATOMIC_RELAXED );
+        if( __atomic_compare_exchange_n( &top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) )
+            return task;
+        // lost race with other thief or owner, deque may still hold tasks
+    }
+}
+
+[[nodiscard]] bool WorkStealingDeque::empty() const noexcept {
+    return __atomic_load_n( &top, __ATOMIC_ACQUIRE ) >= __atomic_load_n( &bottom, __ATOMIC_ACQUIRE );
+}
+
+WorkStealingDeque::Buffer *WorkStealingDeque::grow( Buffer *old, int64_t top, int64_t bottom ) {
+    int64_t capacity = ( old->mask + 1 ) * 2;
+    auto *bigger = new Buffer{ capacity - 1, new Task *[ capacity ], old };
+    for( int64_t i = top; i < bottom; i++ )
+        bigger->slots[ i & bigger->mask ] = old->slots[ i & old->mask ];
+    return bigger;
+}
+
+
+ThreadPool::ThreadPool( uint32_t thread_count ) {
+    if( thread_count == 0 )
+        thread_count = std::max( std::thread::hardware_concurrency(), 1u );
+
+    workers.reserve( thread_count );
+    for( uint32_t i = 0; i < thread_count; i++ ) {
+        workers.push_back( std::make_unique<Worker>() );
+        workers.back()->seed = 2654435761u * ( i + 1 );
+    }
+
+    // workers are started after vector is complete, because they steal from each other
+    for( auto &worker: workers )
+        worker->thread = std::thread{ [this, self = worker.get()](){ run( self ); } };
+}
+
+ThreadPool::~ThreadPool() {
+    __atomic_store_n( &stopping, 1, __ATOMIC_RELEASE );
+    idle.notify_all();
+
+    for( auto &worker: workers )
+        worker->thread.join();
+}
+
+[[nodiscard]] uint32_t ThreadPool::size() const noexcept {
+    return static_cast<uint32_t>( workers.size() );
+}
+
+void ThreadPool::schedule( Task *task ) {
+    if( current_pool == this )
+        current_worker->deque.push( task );
+    else {
+        injection_lock.lock();
+        task->next = nullptr;
+        if( injection_tail != nullptr )
+            injection_tail->next = task;
+        else injection_head = task;
+        injection_tail = task;
+        __sync_add_and_fetch( &injected, 1 );
+        injection_lock.unlock();
+    }
+
+    idle.notify_one();
+}
+
+void ThreadPool::await( uint32_t *done ) noexcept {
+    // worker helps with other tasks, awaited task may be waiting in some deque
+    if( current_pool == this ) {
+        while( __atomic_load_n( done, __ATOMIC_ACQUIRE ) != 1 ) {
+            Task *task = find_task( current_worker );
+            if( task == nullptr )
+                break;
+            task->execute( task );
+        }
+    }
+
+    // no task is left, awaited one is being run by other thread
+    while( true ) {
+        uint32_t state = __atomic_load_n( done, __ATOMIC_ACQUIRE );
+        if( state == 1 )
+            return;
+        if( state == 0 && !__sync_bool_compare_and_swap( done, 0, 2 ) )
+            continue;
+        _simple_futex( done, FUTEX_WAIT, 2 );
+    }
+}
+
+Task *ThreadPool::find_task( Worker *self ) noexcept {
+    if( self != nullptr ) {
+        Task *task = self->deque.pop();
+        if( task != nullptr )
+            return task;
+    }
+
+    if( __atomic_load_n( &injected, __ATOMIC_ACQUIRE ) != 0 ) {
+        injection_lock.lock();
+        Task *task = injection_head;
+        if( task != nullptr ) {
+            injection_head = task->next;
+            if( injection_head == nullptr )
+                injection_tail = nullptr;
+            __sync_sub_and_fetch( &injected, 1 );
+        }
+        injection_lock.unlock();
+
+        if( task != nullptr )
+            return task;
+    }
+
+    auto count = static_cast<uint32_t>( workers.size() );
+    uint32_t start = self != nullptr ? next_random( self->seed ) % count : 0;
+    for( uint32_t i = 0; i < count; i++ ) {
+        Worker *victim = workers[ ( start + i ) % count ].get();
+        if( victim == self )
+            continue;
+
+        Task *task = victim->deque.steal();
+        if( task != nullptr )
+            return task;
+    }
+
+    return nullptr;
+}
+
+void ThreadPool::run( Worker *self ) noexcept {
+    current_pool = this;
+    current_worker = self;
+
+    while( true ) {
+        Task *task = find_task( self );
+        if( task != nullptr ) {
+            task->execute( task );
+            continue;
+        }
+
+        EventCount::Key key = idle.prepare_wait();
+
+        // check again after announcing, submit which did not see us pushed task we find now
+        task = find_task( self );
+        if( task != nullptr ) {
+            idle.cancel_wait();
+            task->execute( task );
+            continue;
+        }
+
+        if( __atomic_load_n( &stopping, __ATOMIC_ACQUIRE ) ) {
+            idle.cancel_wait();
+            break;
+        }
+
+        idle.commit_wait( key );
+    }
+
+    current_pool = nullptr;
+    current_worker = nullptr;
+}
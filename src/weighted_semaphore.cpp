@@ -0,0 +1,28 @@
+#include "weighted_semaphore.hpp"
+
+
+using namespace yarn;
+
+WeightedSemaphore::WeightedSemaphore( uint64_t capacity, Policy policy ) noexcept
+    : waiters( capacity, policy ) {}
+
+void WeightedSemaphore::acquire( uint64_t weight ) noexcept {
+    (void) waiters.acquire( weight );
+}
+
+void WeightedSemaphore::acquire_until( uint64_t weight, std::chrono::steady_clock::time_point deadline ) {
+    if( waiters.tryAcquire( weight ) )
+        return;
+
+    const struct timespec abs_deadline = _to_timespec( deadline );
+    if( !waiters.acquire( weight, &abs_deadline ) )
+        throw TimeoutExpiredException( "Timeout expired before acquire was possible." );
+}
+
+[[nodiscard]] bool WeightedSemaphore::tryAcquire( uint64_t weight ) noexcept {
+    return waiters.tryAcquire( weight );
+}
+
+void WeightedSemaphore::release( uint64_t weight ) noexcept {
+    waiters.release( weight );
+}
@@ -0,0 +1,145 @@
+#include "weighted_waiters.hpp"
+
+#include <cerrno>
+
+
+using namespace yarn;
+
+WeightedWaiters::WeightedWaiters( uint64_t available, Policy policy ) noexcept
+    : available( available ), policy( policy ) {}
+
+[[nodiscard]] bool WeightedWaiters::tryAcquire( uint64_t weight ) noexcept {
+    queue_lock.lock();
+    bool acquired = available >= weight && ( policy == Policy::best_fit || head == nullptr );
+    if( acquired )
+        available -= weight;
+    queue_lock.unlock();
+
+    return acquired;
+}
+
+bool WeightedWaiters::acquire( uint64_t weight, const struct timespec *deadline ) noexcept {
+    if( tryAcquire( weight ) )
+        return true;
+
+    Node node{};
+    node.weight = weight;
+    return wait( node, deadline );
+}
+
+bool WeightedWaiters::acquire( uint64_t weight, std::stop_token token ) noexcept {
+    if( tryAcquire( weight ) )
+        return true;
+
+    Node node{};
+    node.weight = weight;
+    std::stop_callback on_stop( token, [this, &node]() noexcept { cancel( node ); } );
+    return wait( node, nullptr );
+}
+
+void WeightedWaiters::release( uint64_t weight ) noexcept {
+    queue_lock.lock();
+    available += weight;
+    grant();
+    queue_lock.unlock();
+}
+
+bool WeightedWaiters::wait( Node &node, const struct timespec *deadline ) noexcept {
+    queue_lock.lock();
+    // cancelled before it was queued
+    if( node.state != 0 ) {
+        queue_lock.unlock();
+        return false;
+    }
+
+    link( node );
+    // budget could have been released between tryAcquire and enqueue
+    grant();
+    queue_lock.unlock();
+
+    bool expired = false;
+    while( __atomic_load_n( &node.state, __ATOMIC_ACQUIRE ) == 0 && !expired )
+        expired = _deadline_futex( &node.state, 0, deadline ) == -1 && errno == ETIMEDOUT;
+
+    if( !expired )
+        return node.state == 1;
+
+    // state changes only under queue_lock, so budget is either handed over already or we leave
+    queue_lock.lock();
+    uint32_t state = node.state;
+    if( state == 0 ) {
+        // leaving fifo queue may unblock waiters behind us
+        erase( node );
+        grant();
+    }
+    queue_lock.unlock();
+    return state == 1;
+}
+
+void WeightedWaiters::cancel( Node &node ) noexcept {
+    queue_lock.lock();
+    if( node.state == 0 ) {
+        // node is not queued yet if wait was not entered
+        if( node.prev != nullptr || head == &node ) {
+            erase( node );
+            grant();
+        }
+        __atomic_store_n( &node.state, 2, __ATOMIC_RELEASE );
+        _simple_futex( &node.state, FUTEX_WAKE, 1 );
+    }
+    queue_lock.unlock();
+}
+
+void WeightedWaiters::link( Node &node ) noexcept {
+    Node *prev = tail;
+    // equal weights stay in arrival order
+    if( policy == Policy::best_fit )
+        while( prev != nullptr && prev->weight < node.weight )
+            prev = prev->prev;
+
+    node.prev = prev;
+    node.next = prev != nullptr ? prev->next : head;
+
+    if( node.prev != nullptr )
+        node.prev->next = &node;
+    else head = &node;
+
+    if( node.next != nullptr )
+        node.next->prev = &node;
+    else tail = &node;
+}
+
+void WeightedWaiters::erase( Node &node ) noexcept {
+    if( node.prev != nullptr )
+        node.prev->next = node.next;
+    else head = node.next;
+
+    if( node.next != nullptr )
+        node.next->prev = node.prev;
+    else tail = node.prev;
+}
+
+void WeightedWaiters::grant() noexcept {
+    if( policy == Policy::fifo ) {
+        while( head != nullptr && available >= head->weight )
+            hand_over( *head );
+        return;
+    }
+
+    // queue is sorted heaviest first, so every waiter that fits is the largest one that fits;
+    // waiters skipped before it do not fit any more since budget only decreases
+    for( Node *node = head, *next; node != nullptr && available >= tail->weight; node = next ) {
+        next = node->next;
+        if( node->weight <= available )
+            hand_over( *node );
+    }
+}
+
+void WeightedWaiters::hand_over( Node &node ) noexcept {
+    available -= node.weight;
+    erase( node );
+
+    // thread can return as soon as it sees the state, node must not be touched afterwards
+    __atomic_store_n( &node.state, 1, __ATOMIC_RELEASE );
+    _simple_futex( &node.state, FUTEX_WAKE, 1 );
+}
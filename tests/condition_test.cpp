@@ -0,0 +1,322 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include "primitives.hpp"
+#include "priority.hpp"
+#include <thread>
+#include <array>
+
+
+TEST_CASE( "Condition signal", "[condition]" ) {
+    yarn::Lock lock;
+    yarn::Condition condition;
+    uint32_t produced = 0, consumed = 0;
+    constexpr uint32_t items = 1 << 12;
+
+    std::thread consumer{ [&](){
+        for( uint32_t i = 0; i < items; i++ ) {
+            lock.lock();
+            while( produced == consumed )
+                condition.wait( lock );
+            ++consumed;
+            lock.unlock();
+        }
+    } };
+
+    for( uint32_t i = 0; i < items; i++ ) {
+        lock.lock();
+        ++produced;
+        condition.signal();
+        lock.unlock();
+    }
+
+    consumer.join();
+    REQUIRE( consumed == items );
+}
+
+TEST_CASE( "Condition signal_all releases every waiter", "[condition]" ) {
+    constexpr uint32_t thread_count = 64;
+    yarn::Lock lock;
+    yarn::Condition condition;
+    bool released = false;
+    uint32_t waiting = 0, done = 0;
+
+    std::array<std::thread, thread_count> threads;
+    for( auto &t: threads )
+        t = std::thread{ [&](){
+            lock.lock();
+            ++waiting;
+            while( !released )
+                condition.wait( lock );
+            ++done;
+            lock.unlock();
+        } };
+
+    while( true ) {
+        lock.lock();
+        if( waiting == thread_count )
+            break;
+        lock.unlock();
+        std::this_thread::yield();
+    }
+    released = true;
+    condition.signal_all();
+    lock.unlock();
+
+    for( auto &t: threads )
+        t.join();
+
+    REQUIRE( done == thread_count );
+}
+
+TEST_CASE( "Condition timed and predicate waits", "[condition]" ) {
+    yarn::Lock lock;
+    yarn::Condition condition;
+
+    SECTION( "signal without waiters is not remembered" ) {
+        condition.signal();
+        condition.signal_all();
+        lock.lock();
+        REQUIRE_THROWS_AS( condition.wait_until( lock, std::chrono::steady_clock::now() + std::chrono::milliseconds( 5 ) ),
+                           yarn::TimeoutExpiredException );
+        // lock is held again after timeout
+        REQUIRE_FALSE( lock.tryLock() );
+        lock.unlock();
+    }
+
+    SECTION( "predicate wait returns once predicate holds" ) {
+        bool ready = false;
+        std::thread setter{ [&](){
+            lock.lock();
+            ready = true;
+            condition.signal();
+            lock.unlock();
+        } };
+
+        lock.lock();
+        condition.wait( lock, [&](){ return ready; } );
+        REQUIRE( ready );
+        lock.unlock();
+        setter.join();
+    }
+
+    SECTION( "predicate wait_until throws only if predicate is false" ) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 5 );
+        lock.lock();
+        REQUIRE_THROWS_AS( condition.wait_until( lock, deadline, [](){ return false; } ),
+                           yarn::TimeoutExpiredException );
+        REQUIRE_NOTHROW( condition.wait_until( lock, deadline, [](){ return true; } ) );
+        lock.unlock();
+    }
+}
+
+TEST_CASE( "Condition timed out waiter does not lose signal of other waiter", "[condition]" ) {
+    constexpr uint32_t items = 1 << 11;
+    yarn::Lock lock;
+    yarn::Condition condition;
+    uint32_t produced = 0, consumed = 0;
+    bool stop = false;
+
+    // times out all the time, wake-up it took is passed along to consumer
+    std::thread timed{ [&](){
+        lock.lock();
+        while( !stop ) {
+            try {
+                condition.wait_until( lock, std::chrono::steady_clock::now() + std::chrono::microseconds( 20 ) );
+            }
+            catch( yarn::TimeoutExpiredException & ) {}
+            condition.signal();
+        }
+        lock.unlock();
+    } };
+
+    std::thread consumer{ [&](){
+        for( uint32_t i = 1; i <= items; i++ ) {
+            lock.lock();
+            while( produced < i )
+                condition.wait( lock );
+            consumed = i;
+            lock.unlock();
+        }
+    } };
+
+    for( uint32_t i = 1; i <= items; i++ ) {
+        lock.lock();
+        produced = i;
+        condition.signal();
+        lock.unlock();
+
+        while( true ) {
+            lock.lock();
+            bool done = consumed == i;
+            lock.unlock();
+            if( done )
+                break;
+            std::this_thread::yield();
+        }
+    }
+
+    lock.lock();
+    stop = true;
+    lock.unlock();
+
+    consumer.join();
+    timed.join();
+    REQUIRE( consumed == items );
+}
+
+TEST_CASE( "Condition signal_and_unlock", "[condition]" ) {
+    yarn::Lock lock;
+    yarn::Condition condition;
+    uint32_t produced = 0, consumed = 0;
+    constexpr uint32_t items = 1 << 12, consumer_count = 4;
+
+    std::array<std::thread, consumer_count> consumers;
+    for( auto &t: consumers )
+        t = std::thread{ [&](){
+            for( uint32_t i = 0; i < items / consumer_count; i++ ) {
+                lock.lock();
+                condition.wait( lock, [&](){ return produced != consumed; } );
+                ++consumed;
+                lock.unlock();
+            }
+        } };
+
+    for( uint32_t i = 0; i < items; i++ ) {
+        lock.lock();
+        ++produced;
+        condition.signal_and_unlock( lock );
+    }
+
+    for( auto &t: consumers )
+        t.join();
+
+    REQUIRE( consumed == items );
+    REQUIRE( lock.tryLock() );
+    lock.unlock();
+}
+
+TEST_CASE( "PriorityCondition wakes highest priority first", "[condition]" ) {
+    constexpr uint32_t thread_count = 8;
+    constexpr std::array<uint32_t, thread_count> priorities{ 3, 7, 1, 7, 0, 5, 2, 6 };
+    yarn::Lock lock;
+    yarn::PriorityCondition condition;
+    uint32_t waiting = 0, released = 0, done = 0;
+    std::array<uint32_t, thread_count> order{};
+
+    std::array<std::thread, thread_count> threads;
+    for( uint32_t i = 0; i < thread_count; i++ )
+        threads[ i ] = std::thread{ [&, i](){
+            lock.lock();
+            ++waiting;
+            uint32_t ticket = released;
+            condition.wait( lock, priorities[ i ], [&](){ return released != ticket; } );
+            order[ done++ ] = priorities[ i ];
+            lock.unlock();
+        } };
+
+    while( true ) {
+        lock.lock();
+        if( waiting == thread_count )
+            break;
+        lock.unlock();
+        std::this_thread::yield();
+    }
+    lock.unlock();
+
+    for( uint32_t i = 0; i < thread_count; i++ ) {
+        lock.lock();
+        ++released;
+        condition.signal();
+        lock.unlock();
+
+        // wait until signaled thread recorded itself
+        while( true ) {
+            lock.lock();
+            bool recorded = done == i + 1;
+            lock.unlock();
+            if( recorded )
+                break;
+            std::this_thread::yield();
+        }
+    }
+
+    for( auto &t: threads )
+        t.join();
+
+    for( uint32_t i = 1; i < thread_count; i++ )
+        REQUIRE( order[ i - 1 ] >= order[ i ] );
+}
+
+TEST_CASE( "PriorityWaiters aging", "[condition]" ) {
+    yarn::PriorityWaiters waiters( 1000 );
+    yarn::PriorityWaiters::Node low{}, high{};
+
+    waiters.push( low, 0 );
+    waiters.push( high, 1 );
+    REQUIRE( waiters.top() == &high );
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+    waiters.age();
+    // both moved one level up, low is now behind high in level 1
+    REQUIRE( high.priority == 2 );
+    REQUIRE( low.priority == 1 );
+    REQUIRE( waiters.next( high ) == &low );
+
+    waiters.erase( high );
+    waiters.erase( low );
+    REQUIRE( waiters.empty() );
+}
+
+TEST_CASE( "Condition class signals wake only matching waiters", "[condition]" ) {
+    constexpr uint32_t readers = 1u << 0, writers = 1u << 1;
+    yarn::Lock lock;
+    yarn::Condition condition;
+    uint32_t waiting = 0, readable = 0, writable = 0, woken_readers = 0, woken_writers = 0, writer_checks = 0;
+
+    std::thread reader{ [&](){
+        lock.lock();
+        ++waiting;
+        condition.wait( lock, readers, [&](){ return readable != 0; } );
+        ++woken_readers;
+        lock.unlock();
+    } };
+    std::thread writer{ [&](){
+        lock.lock();
+        ++waiting;
+        // every return from futex re-evaluates predicate
+        condition.wait( lock, writers, [&](){ ++writer_checks; return writable != 0; } );
+        ++woken_writers;
+        lock.unlock();
+    } };
+
+    while( true ) {
+        lock.lock();
+        if( waiting == 2 )
+            break;
+        lock.unlock();
+        std::this_thread::yield();
+    }
+    lock.unlock();
+    // let both waiters block on futex
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+
+    lock.lock();
+    uint32_t checks = writer_checks;
+    readable = 1;
+    condition.signal_all( readers );
+    lock.unlock();
+    reader.join();
+    // writer woken up by mistake would have time to re-check its predicate
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+
+    lock.lock();
+    REQUIRE( woken_readers == 1 );
+    REQUIRE( woken_writers == 0 );
+    REQUIRE( writer_checks == checks );
+    writable = 1;
+    condition.signal( writers );
+    lock.unlock();
+    writer.join();
+
+    REQUIRE( woken_writers == 1 );
+}
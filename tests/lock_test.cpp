@@ -1,6 +1,7 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
 #include "primitives.hpp"
+#include "parking_lot.hpp"
 #include <thread>
 #include <array>
 
@@ -108,3 +109,94 @@ TEST_CASE( "Congested locks", "[lock]" ) {
     for( auto counter: counters )
         REQUIRE( counter == thread_count * loops );
 }
+
+TEST_CASE( "ByteLock occupies single byte", "[byte_lock]" ) {
+    static_assert( sizeof( yarn::ByteLock ) == 1 );
+
+    constexpr uint32_t thread_count = 4, loops = 1 << 16;
+    std::array<yarn::ByteLock, 3> locks;
+    std::array<uint32_t, 3> counters{};
+    std::array<std::thread, thread_count> threads;
+
+    for( auto &thread: threads )
+        thread = std::thread{ [&](){
+            for( uint32_t i = 0; i < loops; i++ ) {
+                auto &lock = locks[ i % locks.size() ];
+                if( i % 3 == 0 )
+                    while( !lock.tryLock() );
+                else lock.lock();
+                ++counters[ i % locks.size() ];
+                lock.unlock();
+            }
+        } };
+
+    for( auto &thread: threads )
+        thread.join();
+
+    uint32_t total = 0;
+    for( auto counter: counters )
+        total += counter;
+    REQUIRE( total == thread_count * loops );
+}
+
+TEST_CASE( "ParkingLot parks and unparks by address", "[parking_lot]" ) {
+    uint32_t word = 0;
+
+    SECTION( "failed validation does not park" ) {
+        REQUIRE_FALSE( yarn::ParkingLot::park( &word, []() noexcept { return false; } ) );
+    }
+
+    SECTION( "park times out" ) {
+        struct timespec deadline{};
+        clock_gettime( CLOCK_MONOTONIC, &deadline );
+        deadline.tv_nsec += 1000000;
+        if( deadline.tv_nsec >= 1000000000 ) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        REQUIRE_FALSE( yarn::ParkingLot::park( &word, []() noexcept { return true; }, &deadline ) );
+
+        auto result = yarn::ParkingLot::unpark_one( &word, []( yarn::ParkingLot::UnparkResult ) noexcept -> intptr_t { return 0; } );
+        REQUIRE_FALSE( result.unparked );
+    }
+
+    SECTION( "unpark hands token over" ) {
+        intptr_t token = 0;
+        bool unparked = false;
+        std::thread parked{ [&](){
+            unparked = yarn::ParkingLot::park( &word, [&word]() noexcept {
+                return __atomic_load_n( &word, __ATOMIC_ACQUIRE ) == 0;
+            }, nullptr, &token );
+        } };
+
+        yarn::ParkingLot::UnparkResult result;
+        do {
+            std::this_thread::yield();
+            result = yarn::ParkingLot::unpark_one( &word, []( yarn::ParkingLot::UnparkResult ) noexcept -> intptr_t {
+                return 42;
+            } );
+        } while( !result.unparked );
+        parked.join();
+
+        REQUIRE( unparked );
+        REQUIRE( token == 42 );
+        REQUIRE_FALSE( result.have_more );
+    }
+
+    SECTION( "unpark_all wakes every thread on address only" ) {
+        uint32_t other = 0;
+        std::array<std::thread, 3> threads;
+        for( auto &thread: threads )
+            thread = std::thread{ [&word](){ yarn::ParkingLot::park( &word, []() noexcept { return true; } ); } };
+
+        uint32_t unparked = 0;
+        while( unparked < threads.size() ) {
+            std::this_thread::yield();
+            REQUIRE( yarn::ParkingLot::unpark_all( &other ) == 0 );
+            unparked += yarn::ParkingLot::unpark_all( &word );
+        }
+        for( auto &thread: threads )
+            thread.join();
+        REQUIRE( unparked == threads.size() );
+    }
+}
@@ -0,0 +1,465 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include "primitives.hpp"
+#include "fair_monitor.hpp"
+#include "priority.hpp"
+#include "shared_monitor.hpp"
+#include <thread>
+#include <array>
+
+
+template <typename Monitor_T = yarn::Monitor, typename Release_T>
+uint32_t producer_consumer( Release_T release, Monitor_T &&monitor = Monitor_T{} ) {
+    uint32_t produced = 0, consumed = 0;
+    constexpr uint32_t items = 1 << 12, consumer_count = 4;
+
+    std::array<std::thread, consumer_count> consumers;
+    for( auto &t: consumers )
+        t = std::thread{ [&](){
+            for( uint32_t i = 0; i < items / consumer_count; i++ ) {
+                monitor.lock();
+                monitor.wait_for( [&]() noexcept { return produced != consumed; } );
+                ++consumed;
+                monitor.unlock();
+            }
+        } };
+
+    for( uint32_t i = 0; i < items; i++ ) {
+        monitor.lock();
+        ++produced;
+        release( monitor );
+    }
+
+    for( auto &t: consumers )
+        t.join();
+
+    return consumed;
+}
+
+
+TEST_CASE( "Monitor tests", "[monitor]" ) {
+    yarn::Monitor monitor;
+
+    SECTION( "tryLock must return false on locked Monitor" ) {
+        monitor.lock();
+        REQUIRE_FALSE( monitor.tryLock() );
+        monitor.unlock();
+        REQUIRE( monitor.tryLock() );
+        monitor.unlock();
+    }
+
+    SECTION( "wait_for with true predicate returns immediately" ) {
+        monitor.lock();
+        monitor.wait_for( []() noexcept { return true; } );
+        REQUIRE_FALSE( monitor.tryLock() );
+        monitor.unlock();
+    }
+
+    SECTION( "signal_all releases waiters with false predicates" ) {
+        constexpr uint32_t thread_count = 8;
+        uint32_t waiting = 0, released = 0;
+        std::array<std::thread, thread_count> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&](){
+                monitor.lock();
+                ++waiting;
+                monitor.wait_for( []() noexcept { return false; } );
+                ++released;
+                monitor.unlock();
+            } };
+
+        bool all_waiting = false;
+        while( !all_waiting ) {
+            monitor.lock();
+            all_waiting = waiting == thread_count;
+            if( all_waiting )
+                monitor.signal_all();
+            monitor.unlock();
+        }
+
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( released == thread_count );
+    }
+
+    SECTION( "Producer and consumers with unlock" ) {
+        REQUIRE( producer_consumer( []( yarn::Monitor &m ){ m.unlock(); } ) == 1 << 12 );
+    }
+
+    SECTION( "Producer and consumers with signal_and_unlock" ) {
+        REQUIRE( producer_consumer( []( yarn::Monitor &m ){ m.signal_and_unlock(); } ) == 1 << 12 );
+    }
+
+    SECTION( "Keyed waiters are evaluated only when their key is notified" ) {
+        constexpr uint32_t key_a = 1, key_b = 2;
+        uint32_t value_a = 0, value_b = 0;
+        uint32_t evaluations_b = 0;
+        bool waiting_b = false;
+
+        std::thread waiter_b{ [&](){
+            monitor.lock();
+            waiting_b = true;
+            monitor.wait_for( key_b, [&]() noexcept { ++evaluations_b; return value_b != 0; } );
+            monitor.unlock();
+        } };
+
+        while( true ) {
+            monitor.lock();
+            if( waiting_b )
+                break;
+            monitor.unlock();
+            std::this_thread::yield();
+        }
+        uint32_t before = evaluations_b;
+        for( uint32_t i = 0; i < 100; i++ ) {
+            ++value_a;
+            monitor.unlock( key_a );
+            monitor.lock();
+        }
+        REQUIRE( evaluations_b == before );
+
+        value_b = 1;
+        monitor.unlock( key_b );
+        waiter_b.join();
+        REQUIRE( evaluations_b > before );
+    }
+}
+
+TEST_CASE( "Monitor timed and cancellable waits", "[monitor]" ) {
+    yarn::Monitor monitor;
+
+    SECTION( "wait_until throws after deadline with monitor held" ) {
+        monitor.lock();
+        REQUIRE_THROWS_AS( monitor.wait_until( std::chrono::steady_clock::now() + std::chrono::milliseconds( 5 ),
+                                               []() noexcept { return false; } ),
+                           yarn::TimeoutExpiredException );
+        REQUIRE_FALSE( monitor.tryLock() );
+        REQUIRE_NOTHROW( monitor.wait_until( std::chrono::steady_clock::now(), []() noexcept { return true; } ) );
+        monitor.unlock();
+    }
+
+    SECTION( "stop request cancels all parked waiters" ) {
+        constexpr uint32_t thread_count = 64;
+        std::stop_source stop;
+        uint32_t waiting = 0, cancelled = 0;
+
+        std::array<std::thread, thread_count> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&](){
+                monitor.lock();
+                ++waiting;
+                if( !monitor.wait_for( stop.get_token(), []() noexcept { return false; } ) )
+                    ++cancelled;
+                monitor.silent_unlock();
+            } };
+
+        bool all_waiting = false;
+        while( !all_waiting ) {
+            monitor.lock();
+            all_waiting = waiting == thread_count;
+            monitor.unlock();
+        }
+
+        stop.request_stop();
+        for( auto &t: threads )
+            t.join();
+
+        REQUIRE( cancelled == thread_count );
+
+        // already requested stop does not block
+        monitor.lock();
+        REQUIRE_FALSE( monitor.wait_for( stop.get_token(), []() noexcept { return false; } ) );
+        monitor.unlock();
+    }
+
+    SECTION( "timeout and cancel racing with hand-over do not strand monitor" ) {
+        constexpr uint32_t iterations = 512;
+        uint32_t ready = 0;
+        bool stranded = false;
+
+        for( uint32_t i = 1; i <= iterations && !stranded; i++ ) {
+            std::stop_source stop;
+            auto predicate = [&, i]() noexcept { return ready == i; };
+
+            std::thread timed{ [&](){
+                monitor.lock();
+                try {
+                    monitor.wait_until( std::chrono::steady_clock::now() + std::chrono::microseconds( i % 64 ),
+                                        predicate );
+                }
+                catch( yarn::TimeoutExpiredException & ) {}
+                monitor.unlock();
+            } };
+            std::thread cancelled{ [&](){
+                monitor.lock();
+                (void) monitor.wait_for( stop.get_token(), predicate );
+                monitor.unlock();
+            } };
+            std::thread stopper{ [&](){ stop.request_stop(); } };
+
+            monitor.lock();
+            ready = i;
+            if( i % 2 )
+                monitor.unlock();
+            else monitor.signal_and_unlock();
+
+            timed.join();
+            cancelled.join();
+            stopper.join();
+
+            stranded = !monitor.tryLock();
+            if( !stranded )
+                monitor.silent_unlock();
+        }
+
+        REQUIRE_FALSE( stranded );
+    }
+}
+
+TEST_CASE( "Monitor cells", "[monitor]" ) {
+    yarn::Monitor monitor;
+    yarn::Monitor::Cell<uint32_t> items{ monitor, 0 }, unrelated{ monitor, 0 };
+
+    SECTION( "Predicates reading cells are reevaluated only after write to them" ) {
+        uint32_t evaluations = 0;
+        bool waiting = false;
+
+        std::thread waiter{ [&](){
+            monitor.lock();
+            waiting = true;
+            monitor.wait_for( [&]() noexcept { ++evaluations; return items.get() != 0; } );
+            items.set( items.get() - 1 );
+            monitor.unlock();
+        } };
+
+        while( true ) {
+            monitor.lock();
+            if( waiting )
+                break;
+            monitor.unlock();
+            std::this_thread::yield();
+        }
+
+        uint32_t before = evaluations;
+        for( uint32_t i = 0; i < 100; i++ ) {
+            unrelated.set( unrelated.get() + 1 );
+            monitor.unlock();
+            monitor.lock();
+        }
+        REQUIRE( evaluations == before );
+        REQUIRE( unrelated.version() == 100 );
+
+        items.set( 1 );
+        monitor.unlock();
+        waiter.join();
+
+        monitor.lock();
+        REQUIRE( items.get() == 0 );
+        monitor.unlock();
+    }
+
+    SECTION( "Producer and consumers through cells" ) {
+        constexpr uint32_t count = 1 << 12, consumer_count = 4;
+        uint32_t consumed = 0;
+
+        std::array<std::thread, consumer_count> consumers;
+        for( auto &t: consumers )
+            t = std::thread{ [&](){
+                for( uint32_t i = 0; i < count / consumer_count; i++ ) {
+                    monitor.lock();
+                    monitor.wait_for( [&]() noexcept { return items.get() != 0; } );
+                    items.set( items.get() - 1 );
+                    ++consumed;
+                    monitor.unlock();
+                }
+            } };
+
+        for( uint32_t i = 0; i < count; i++ ) {
+            monitor.lock();
+            items.set( items.get() + 1 );
+            monitor.unlock();
+        }
+
+        for( auto &t: consumers )
+            t.join();
+
+        REQUIRE( consumed == count );
+    }
+}
+
+TEST_CASE( "FairMonitor", "[monitor]" ) {
+    SECTION( "tryLock must return false on locked FairMonitor" ) {
+        yarn::FairMonitor monitor;
+        monitor.lock();
+        REQUIRE_FALSE( monitor.tryLock() );
+        monitor.unlock();
+        REQUIRE( monitor.tryLock() );
+        monitor.unlock();
+    }
+
+    SECTION( "Blocked threads are served in arrival order" ) {
+        constexpr uint32_t thread_count = 8;
+        yarn::FairMonitor monitor;
+        std::array<uint32_t, thread_count> order{};
+        uint32_t served = 0;
+        std::array<std::thread, thread_count> threads;
+
+        monitor.lock();
+        for( uint32_t i = 0; i < thread_count; i++ ) {
+            threads[ i ] = std::thread{ [&, i](){
+                monitor.lock();
+                order[ served++ ] = i;
+                monitor.unlock();
+            } };
+            // give thread time to block in lock before next one arrives
+            std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        }
+        monitor.unlock();
+
+        for( auto &t: threads )
+            t.join();
+
+        for( uint32_t i = 0; i < thread_count; i++ )
+            REQUIRE( order[ i ] == i );
+    }
+
+    SECTION( "Producer and consumers" ) {
+        REQUIRE( producer_consumer( []( yarn::FairMonitor &m ){ m.unlock(); }, yarn::FairMonitor{} ) == 1 << 12 );
+        REQUIRE( producer_consumer( []( yarn::FairMonitor &m ){ m.unlock(); }, yarn::FairMonitor{ 50 } ) == 1 << 12 );
+    }
+}
+
+TEST_CASE( "PriorityMonitor serves highest priority satisfied waiter first", "[monitor]" ) {
+    constexpr uint32_t thread_count = 8;
+    constexpr std::array<uint32_t, thread_count> priorities{ 3, 7, 1, 7, 0, 5, 2, 6 };
+    yarn::PriorityMonitor monitor;
+    uint32_t waiting = 0, tokens = 0, done = 0;
+    std::array<uint32_t, thread_count> order{};
+
+    std::array<std::thread, thread_count> threads;
+    for( uint32_t i = 0; i < thread_count; i++ )
+        threads[ i ] = std::thread{ [&, i](){
+            monitor.lock();
+            ++waiting;
+            monitor.wait_for( priorities[ i ], [&]() noexcept { return tokens != 0; } );
+            --tokens;
+            order[ done++ ] = priorities[ i ];
+            monitor.unlock();
+        } };
+
+    while( true ) {
+        monitor.lock();
+        if( waiting == thread_count )
+            break;
+        monitor.unlock();
+        std::this_thread::yield();
+    }
+    tokens = thread_count;
+    monitor.unlock();
+
+    for( auto &t: threads )
+        t.join();
+
+    for( uint32_t i = 1; i < thread_count; i++ )
+        REQUIRE( order[ i - 1 ] >= order[ i ] );
+}
+
+TEST_CASE( "SharedMonitor", "[monitor]" ) {
+    yarn::SharedMonitor monitor;
+
+    SECTION( "Shared entries coexist, exclusive entry excludes all" ) {
+        REQUIRE( monitor.tryLockShared() );
+        REQUIRE( monitor.tryLockShared() );
+        REQUIRE_FALSE( monitor.tryLock() );
+        monitor.unlock_shared();
+        monitor.unlock_shared();
+        REQUIRE( monitor.tryLock() );
+        REQUIRE_FALSE( monitor.tryLockShared() );
+        monitor.unlock();
+    }
+
+    SECTION( "Exclusive entry keeps interface of Monitor" ) {
+        REQUIRE( producer_consumer( []( yarn::SharedMonitor &m ){ m.unlock(); }, yarn::SharedMonitor{} ) == 1 << 12 );
+        REQUIRE( producer_consumer( []( yarn::SharedMonitor &m ){ m.signal_and_unlock(); },
+                                    yarn::SharedMonitor{} ) == 1 << 12 );
+
+        yarn::Monitor::Cell<uint32_t> items{ monitor, 0 };
+        monitor.lock();
+        REQUIRE_THROWS_AS( monitor.wait_until( std::chrono::steady_clock::now() + std::chrono::milliseconds( 5 ),
+                                               [&]() noexcept { return items.get() != 0; } ),
+                           yarn::TimeoutExpiredException );
+        REQUIRE_FALSE( monitor.tryLockShared() );
+        std::stop_source stop;
+        stop.request_stop();
+        REQUIRE_FALSE( monitor.wait_for( stop.get_token(), []() noexcept { return false; } ) );
+        monitor.unlock();
+
+        // exclusive entry waits for shared owner, keyed waiter is served by unlock( key )
+        constexpr uint32_t key = 7;
+        bool entered = false, served = false;
+        monitor.lock_shared();
+        std::thread writer{ [&](){
+            monitor.lock();
+            entered = true;
+            monitor.wait_for( key, [&]() noexcept { return items.get() == 1; } );
+            served = true;
+            monitor.unlock();
+        } };
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+        REQUIRE_FALSE( entered );
+        monitor.unlock_shared();
+
+        bool waiting = false;
+        while( !waiting ) {
+            monitor.lock();
+            waiting = entered;
+            if( waiting ) {
+                items.set( 1 );
+                monitor.unlock( key );
+            }
+            else monitor.unlock();
+        }
+
+        writer.join();
+        REQUIRE( served );
+    }
+
+    SECTION( "Exclusive release serves shared and exclusive waiters" ) {
+        constexpr uint32_t reader_count = 4, rounds = 1 << 10;
+        uint32_t version = 0, writer_seen = 0;
+        std::array<uint32_t, reader_count> seen{};
+
+        std::array<std::thread, reader_count> readers;
+        for( uint32_t r = 0; r < reader_count; r++ )
+            readers[ r ] = std::thread{ [&, r](){
+                monitor.lock_shared();
+                for( uint32_t i = 1; i <= rounds; i++ ) {
+                    monitor.wait_for_shared( [&, i]() noexcept { return version >= i; } );
+                    seen[ r ] = i;
+                }
+                monitor.unlock_shared();
+            } };
+
+        std::thread checker{ [&](){
+            monitor.lock();
+            monitor.wait_for( [&]() noexcept { return version == rounds; } );
+            writer_seen = version;
+            monitor.unlock();
+        } };
+
+        for( uint32_t i = 0; i < rounds; i++ ) {
+            monitor.lock();
+            ++version;
+            monitor.unlock();
+        }
+
+        for( auto &t: readers )
+            t.join();
+        checker.join();
+
+        REQUIRE( writer_seen == rounds );
+        for( auto value: seen )
+            REQUIRE( value == rounds );
+    }
+}
@@ -0,0 +1,216 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include "bounded_queue.hpp"
+#include "spsc_ring.hpp"
+#include "mailbox.hpp"
+#include <thread>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+
+TEST_CASE( "BoundedQueue single thread", "[bounded_queue]" ) {
+    yarn::BoundedQueue<uint32_t> queue{ 3 };
+    REQUIRE( queue.capacity() == 4 );
+
+    SECTION( "try operations respect capacity and order" ) {
+        for( uint32_t i = 0; i < 4; i++ )
+            REQUIRE( queue.tryPush( i ) );
+        REQUIRE_FALSE( queue.tryPush( 4u ) );
+
+        uint32_t item = 0;
+        for( uint32_t i = 0; i < 4; i++ ) {
+            REQUIRE( queue.tryPop( item ) );
+            REQUIRE( item == i );
+        }
+        REQUIRE_FALSE( queue.tryPop( item ) );
+    }
+
+    SECTION( "timed operations throw" ) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 2 );
+        REQUIRE_THROWS_AS( queue.pop_until( deadline ), yarn::TimeoutExpiredException );
+
+        std::array<uint32_t, 4> items{ 1, 2, 3, 4 };
+        REQUIRE( queue.tryPush_n( items.data(), 4 ) == 4 );
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 2 );
+        REQUIRE_THROWS_AS( queue.push_until( 5u, deadline ), yarn::TimeoutExpiredException );
+
+        std::array<uint32_t, 8> popped{};
+        REQUIRE( queue.pop_n( popped.data(), 8 ) == 4 );
+        REQUIRE( popped[ 3 ] == 4 );
+    }
+
+    SECTION( "items left in queue are destroyed" ) {
+        auto shared = std::make_shared<int>( 1 );
+        {
+            yarn::BoundedQueue<std::shared_ptr<int>> owners{ 4 };
+            REQUIRE( owners.tryPush( shared ) );
+            REQUIRE( owners.tryPush( shared ) );
+            REQUIRE( shared.use_count() == 3 );
+        }
+        REQUIRE( shared.use_count() == 1 );
+    }
+
+    SECTION( "capacity not representable as power of 2 is rejected" ) {
+        REQUIRE_THROWS_AS( yarn::BoundedQueue<uint32_t>{ ( 1u << 31 ) + 1 }, std::invalid_argument );
+        REQUIRE_THROWS_AS( yarn::BoundedQueue<uint32_t>{ UINT32_MAX }, std::invalid_argument );
+    }
+}
+
+TEST_CASE( "BoundedQueue many producers and consumers", "[bounded_queue]" ) {
+    constexpr uint32_t per_thread = 1 << 15, thread_count = 3;
+    yarn::BoundedQueue<uint64_t> queue{ 16 };
+    uint64_t sum = 0;
+
+    std::array<std::thread, thread_count> producers, consumers;
+    for( uint32_t t = 0; t < thread_count; t++ ) {
+        producers[ t ] = std::thread{ [&queue, t](){
+            std::array<uint64_t, 8> batch{};
+            for( uint32_t i = 0; i < per_thread; i += batch.size() ) {
+                for( uint32_t j = 0; j < batch.size(); j++ )
+                    batch[ j ] = t * per_thread + i + j + 1;
+                if( i % 16 )
+                    queue.push_n( batch.data(), batch.size() );
+                else for( auto item: batch )
+                    queue.push( item );
+            }
+        } };
+        consumers[ t ] = std::thread{ [&queue, &sum](){
+            uint64_t local = 0;
+            std::array<uint64_t, 8> batch{};
+            for( uint32_t received = 0; received < per_thread; ) {
+                uint32_t count = queue.pop_n( batch.data(), std::min<uint32_t>( batch.size(), per_thread - received ) );
+                for( uint32_t j = 0; j < count; j++ )
+                    local += batch[ j ];
+                received += count;
+            }
+            __sync_fetch_and_add( &sum, local );
+        } };
+    }
+
+    for( auto &t: producers )
+        t.join();
+    for( auto &t: consumers )
+        t.join();
+
+    uint64_t total = uint64_t( per_thread ) * thread_count;
+    REQUIRE( sum == total * ( total + 1 ) / 2 );
+}
+
+TEST_CASE( "SpscRing single thread", "[spsc_ring]" ) {
+    yarn::SpscRing<uint32_t> ring{ 5 };
+    REQUIRE( ring.capacity() == 8 );
+
+    std::array<uint32_t, 10> items{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    REQUIRE( ring.tryPush_n( items.data(), 10 ) == 8 );
+    REQUIRE_FALSE( ring.tryPush( 8u ) );
+
+    uint32_t item = 0;
+    REQUIRE( ring.tryPop( item ) );
+    REQUIRE( item == 0 );
+
+    std::array<uint32_t, 10> popped{};
+    REQUIRE( ring.tryPop_n( popped.data(), 10 ) == 7 );
+    REQUIRE( popped[ 6 ] == 7 );
+    REQUIRE_FALSE( ring.tryPop( item ) );
+
+    REQUIRE_THROWS_AS( yarn::SpscRing<uint32_t>{ ( 1u << 31 ) + 1 }, std::invalid_argument );
+    REQUIRE_THROWS_AS( ( yarn::SpscRing<uint32_t, true>{ UINT32_MAX } ), std::invalid_argument );
+}
+
+TEST_CASE( "SpscRing producer and consumer", "[spsc_ring]" ) {
+    constexpr uint64_t items = 1 << 20;
+
+    SECTION( "batches" ) {
+        yarn::SpscRing<uint64_t> ring{ 64 };
+        uint64_t sum = 0;
+        std::thread consumer{ [&](){
+            std::array<uint64_t, 16> batch{};
+            for( uint64_t received = 0; received < items; ) {
+                uint32_t count = ring.tryPop_n( batch.data(), batch.size() );
+                for( uint32_t i = 0; i < count; i++ )
+                    sum += batch[ i ];
+                received += count;
+                if( count == 0 )
+                    std::this_thread::yield();
+            }
+        } };
+
+        for( uint64_t i = 0; i < items; i++ )
+            while( !ring.tryPush( i ) )
+                std::this_thread::yield();
+        consumer.join();
+        REQUIRE( sum == items * ( items - 1 ) / 2 );
+    }
+
+    SECTION( "blocking" ) {
+        yarn::SpscRing<uint64_t, true> ring{ 16 };
+        uint64_t sum = 0;
+        std::thread consumer{ [&](){
+            for( uint64_t i = 0; i < items; i++ )
+                sum += ring.pop();
+        } };
+
+        for( uint64_t i = 0; i < items; i++ )
+            ring.push( i );
+        consumer.join();
+        REQUIRE( sum == items * ( items - 1 ) / 2 );
+    }
+}
+
+struct Message : yarn::MailboxNode {
+    uint32_t sender = 0;
+    uint32_t sequence = 0;
+};
+
+TEST_CASE( "Mailbox single thread", "[mailbox]" ) {
+    yarn::Mailbox<Message> mailbox;
+    std::array<Message, 3> messages{};
+    REQUIRE( mailbox.tryPop() == nullptr );
+
+    for( auto &message: messages )
+        mailbox.push( message );
+    for( auto &message: messages )
+        REQUIRE( mailbox.tryPop() == &message );
+    REQUIRE( mailbox.tryPop() == nullptr );
+
+    // messages can be reused after pop
+    mailbox.push( messages[ 1 ] );
+    REQUIRE( mailbox.tryPop() == &messages[ 1 ] );
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 2 );
+    REQUIRE_THROWS_AS( mailbox.pop_until( deadline ), yarn::TimeoutExpiredException );
+}
+
+TEST_CASE( "Mailbox many producers", "[mailbox]" ) {
+    constexpr uint32_t producer_count = 4, per_producer = 1 << 14;
+    yarn::Mailbox<Message> mailbox;
+    std::vector<Message> messages( producer_count * per_producer );
+
+    std::array<std::thread, producer_count> producers;
+    for( uint32_t p = 0; p < producer_count; p++ )
+        producers[ p ] = std::thread{ [&, p](){
+            for( uint32_t i = 0; i < per_producer; i++ ) {
+                Message &message = messages[ p * per_producer + i ];
+                message.sender = p;
+                message.sequence = i;
+                mailbox.push( message );
+                if( i % 1024 == 0 )
+                    std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+            }
+        } };
+
+    // messages of every producer arrive in order
+    std::array<uint32_t, producer_count> expected{};
+    bool ordered = true;
+    for( uint32_t i = 0; i < producer_count * per_producer; i++ ) {
+        Message *message = mailbox.pop();
+        ordered = ordered && message->sequence == expected[ message->sender ]++;
+    }
+
+    for( auto &t: producers )
+        t.join();
+    REQUIRE( ordered );
+    REQUIRE( mailbox.tryPop() == nullptr );
+}
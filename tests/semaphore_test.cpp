@@ -0,0 +1,569 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include "primitives.hpp"
+#include "fair_semaphore.hpp"
+#include "weighted_semaphore.hpp"
+#include "sharded_semaphore.hpp"
+#include "compact_semaphore.hpp"
+#include "rate_limiter.hpp"
+#include "adaptive_limiter.hpp"
+#include "semaphore_set.hpp"
+#include <thread>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <chrono>
+
+
+TEST_CASE( "Semaphore batched take and give", "[semaphore]" ) {
+    yarn::Semaphore semaphore{ 0 };
+
+    SECTION( "tryTake of count is all or nothing" ) {
+        semaphore.give( 3 );
+        REQUIRE_FALSE( semaphore.tryTake( 4 ) );
+        REQUIRE( semaphore.value() == 3 );
+        REQUIRE( semaphore.tryTake( 3 ) );
+        REQUIRE( semaphore.value() == 0 );
+    }
+
+    SECTION( "take_n with timeout must throw exception and take nothing" ) {
+        semaphore.give( 2 );
+        REQUIRE_THROWS_AS( semaphore.take_n( 3, 1000 ), yarn::TimeoutExpiredException );
+        REQUIRE( semaphore.value() == 2 );
+        semaphore.take_n( 2, 1000 );
+        REQUIRE( semaphore.value() == 0 );
+    }
+
+    SECTION( "single give wakes multiple waiters" ) {
+        constexpr uint32_t thread_count = 8;
+        std::array<std::thread, thread_count> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&semaphore](){ semaphore.take(); } };
+
+        semaphore.give( thread_count );
+
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( semaphore.value() == 0 );
+    }
+
+    SECTION( "mixed single and batch waiters are all served" ) {
+        constexpr uint32_t rounds = 1 << 10;
+        std::thread big{ [&semaphore](){
+            for( uint32_t i = 0; i < rounds; i++ )
+                semaphore.take_n( 4 );
+        } };
+        std::thread small{ [&semaphore](){
+            for( uint32_t i = 0; i < rounds; i++ )
+                semaphore.take();
+        } };
+
+        for( uint32_t i = 0; i < rounds; i++ ) {
+            semaphore.give( 3 );
+            semaphore.give( 2 );
+        }
+
+        big.join();
+        small.join();
+        REQUIRE( semaphore.value() == 0 );
+    }
+}
+
+TEST_CASE( "FairSemaphore serves takers in arrival order", "[fair_semaphore]" ) {
+    yarn::FairSemaphore semaphore{ 0 };
+    yarn::Lock order_lock;
+    std::vector<uint32_t> order;
+    constexpr uint32_t thread_count = 6;
+    std::array<std::thread, thread_count> threads;
+
+    for( uint32_t i = 0; i < thread_count; i++ ) {
+        threads[ i ] = std::thread{ [&, i](){
+            semaphore.take();
+            order_lock.lock();
+            order.push_back( i );
+            order_lock.unlock();
+        } };
+        // let thread block before next one arrives
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        REQUIRE_FALSE( semaphore.tryTake() );
+    }
+
+    for( uint32_t i = 0; i < thread_count; i++ ) {
+        semaphore.give();
+        while( true ) {
+            order_lock.lock();
+            size_t served = order.size();
+            order_lock.unlock();
+            if( served == i + 1 )
+                break;
+            std::this_thread::yield();
+        }
+    }
+
+    for( auto &t: threads )
+        t.join();
+    for( uint32_t i = 0; i < thread_count; i++ )
+        REQUIRE( order[ i ] == i );
+}
+
+TEST_CASE( "FairSemaphore weighted, timed and cancelled takes", "[fair_semaphore]" ) {
+    yarn::FairSemaphore semaphore{ 2 };
+
+    SECTION( "large request blocks younger small ones until it leaves" ) {
+        bool small_done = false, timed_out = false;
+        std::thread big{ [&](){
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 50 );
+            try {
+                semaphore.take_until( 3, deadline );
+            }
+            catch( const yarn::TimeoutExpiredException & ) {
+                timed_out = true;
+            }
+        } };
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+
+        std::thread small{ [&](){
+            semaphore.take_n( 2 );
+            small_done = true;
+        } };
+
+        big.join();
+        small.join();
+        REQUIRE( timed_out );
+        REQUIRE( small_done );
+        REQUIRE_FALSE( semaphore.tryTake() );
+    }
+
+    SECTION( "cancelled taker takes nothing" ) {
+        std::stop_source source;
+        bool result = true;
+        std::thread taker{ [&](){ result = semaphore.take_n( 5, source.get_token() ); } };
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        source.request_stop();
+        taker.join();
+
+        REQUIRE_FALSE( result );
+        REQUIRE( semaphore.tryTake( 2 ) );
+    }
+
+    SECTION( "give hands units to several takers" ) {
+        constexpr uint32_t rounds = 1 << 12;
+        std::array<std::thread, 4> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&semaphore](){
+                for( uint32_t i = 0; i < rounds; i++ ) {
+                    semaphore.take_n( 2 );
+                    semaphore.give( 2 );
+                }
+            } };
+
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( semaphore.tryTake( 2 ) );
+        REQUIRE_FALSE( semaphore.tryTake() );
+    }
+
+    SECTION( "hand-over racing with timeouts and cancels loses no unit" ) {
+        constexpr uint32_t rounds = 1 << 11;
+        std::array<std::thread, 4> threads;
+        for( uint32_t t = 0; t < threads.size(); t++ )
+            threads[ t ] = std::thread{ [&semaphore, t](){
+                for( uint32_t i = 0; i < rounds; i++ ) {
+                    bool taken = true;
+                    if( t % 2 ) {
+                        std::stop_source source;
+                        std::thread stopper{ [&source](){ source.request_stop(); } };
+                        taken = semaphore.take_n( 1, source.get_token() );
+                        stopper.join();
+                    }
+                    else {
+                        try {
+                            semaphore.take_until( 1, std::chrono::steady_clock::now() +
+                                                     std::chrono::microseconds( i % 32 ) );
+                        }
+                        catch( const yarn::TimeoutExpiredException & ) {
+                            taken = false;
+                        }
+                    }
+                    if( taken )
+                        semaphore.give( 1 );
+                }
+            } };
+
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( semaphore.tryTake( 2 ) );
+        REQUIRE_FALSE( semaphore.tryTake() );
+    }
+}
+
+TEST_CASE( "WeightedSemaphore byte budget", "[weighted_semaphore]" ) {
+    constexpr uint64_t capacity = uint64_t( 1 ) << 40;
+
+    SECTION( "acquire is all or nothing" ) {
+        yarn::WeightedSemaphore semaphore{ capacity };
+        REQUIRE( semaphore.tryAcquire( capacity - 10 ) );
+        REQUIRE_FALSE( semaphore.tryAcquire( 11 ) );
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 5 );
+        REQUIRE_THROWS_AS( semaphore.acquire_until( 11, deadline ), yarn::TimeoutExpiredException );
+        REQUIRE( semaphore.tryAcquire( 10 ) );
+        semaphore.release( capacity );
+        REQUIRE( semaphore.tryAcquire( capacity ) );
+    }
+
+    SECTION( "release wakes as many waiters as fit" ) {
+        yarn::WeightedSemaphore semaphore{ capacity };
+        semaphore.acquire( capacity );
+
+        uint32_t served = 0;
+        std::array<std::thread, 4> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&](){
+                semaphore.acquire( capacity / 4 );
+                __sync_add_and_fetch( &served, 1 );
+            } };
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+
+        semaphore.release( capacity / 2 );
+        while( __sync_fetch_and_add( &served, 0 ) != 2 )
+            std::this_thread::yield();
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        REQUIRE( __sync_fetch_and_add( &served, 0 ) == 2 );
+
+        semaphore.release( capacity / 2 );
+        for( auto &t: threads )
+            t.join();
+        REQUIRE_FALSE( semaphore.tryAcquire( 1 ) );
+    }
+
+    SECTION( "best fit serves smaller waiter behind large one" ) {
+        yarn::WeightedSemaphore semaphore{ 100, yarn::WeightedSemaphore::Policy::best_fit };
+        semaphore.acquire( 100 );
+
+        bool small_done = false;
+        std::thread big{ [&semaphore](){ semaphore.acquire( 80 ); } };
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        std::thread small{ [&](){
+            semaphore.acquire( 30 );
+            small_done = true;
+        } };
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+
+        semaphore.release( 40 );
+        small.join();
+        REQUIRE( small_done );
+
+        // remaining budget of main thread and budget of small waiter
+        semaphore.release( 60 );
+        semaphore.release( 30 );
+        big.join();
+        REQUIRE( semaphore.tryAcquire( 20 ) );
+        REQUIRE_FALSE( semaphore.tryAcquire( 1 ) );
+    }
+
+    SECTION( "best fit serves largest waiter that fits" ) {
+        constexpr std::array<uint64_t, 3> weights{ 25, 50, 30 };
+        yarn::WeightedSemaphore semaphore{ 0, yarn::WeightedSemaphore::Policy::best_fit };
+
+        uint64_t served = 0;
+        std::array<std::thread, weights.size()> threads;
+        for( uint32_t i = 0; i < weights.size(); i++ ) {
+            threads[ i ] = std::thread{ [&, i](){
+                semaphore.acquire( weights[ i ] );
+                __sync_add_and_fetch( &served, weights[ i ] );
+            } };
+            std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+        }
+
+        // 50 is served, rest of budget fits neither 25 nor 30
+        semaphore.release( 60 );
+        while( __sync_fetch_and_add( &served, 0 ) != 50 )
+            std::this_thread::yield();
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        REQUIRE( __sync_fetch_and_add( &served, 0 ) == 50 );
+
+        semaphore.release( 45 );
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( served == 105 );
+        REQUIRE_FALSE( semaphore.tryAcquire( 1 ) );
+    }
+}
+
+TEST_CASE( "ShardedSemaphore preserves units", "[sharded_semaphore]" ) {
+    SECTION( "units are stolen from other shards" ) {
+        yarn::ShardedSemaphore semaphore{ 7, 4 };
+        REQUIRE( semaphore.available() == 7 );
+        for( uint32_t i = 0; i < 7; i++ )
+            REQUIRE( semaphore.tryTake() );
+        REQUIRE_FALSE( semaphore.tryTake() );
+        REQUIRE( semaphore.available() == 0 );
+    }
+
+    SECTION( "blocked takers are woken by give" ) {
+        yarn::ShardedSemaphore semaphore{ 0, 4 };
+        std::array<std::thread, 4> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&semaphore](){ semaphore.take(); } };
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+
+        semaphore.give( 4 );
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( semaphore.available() == 0 );
+    }
+
+    SECTION( "concurrent churn keeps exact count" ) {
+        constexpr uint32_t units = 3, rounds = 1 << 15;
+        yarn::ShardedSemaphore semaphore{ units };
+        std::array<std::thread, 6> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&semaphore](){
+                for( uint32_t i = 0; i < rounds; i++ ) {
+                    semaphore.take();
+                    semaphore.give();
+                }
+            } };
+
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( semaphore.available() == units );
+    }
+}
+
+TEST_CASE( "CompactSemaphore single word", "[compact_semaphore]" ) {
+    SECTION( "tryTake and value" ) {
+        yarn::CompactSemaphore semaphore{ 2 };
+        REQUIRE( semaphore.value() == 2 );
+        REQUIRE( semaphore.tryTake() );
+        REQUIRE( semaphore.tryTake() );
+        REQUIRE_FALSE( semaphore.tryTake() );
+        semaphore.give( 3 );
+        REQUIRE( semaphore.value() == 3 );
+    }
+
+    SECTION( "producer consumer" ) {
+        constexpr uint32_t items = 1 << 16;
+        yarn::CompactSemaphore full{ 0 }, empty{ 4 };
+        std::array<std::thread, 2> consumers;
+        for( auto &t: consumers )
+            t = std::thread{ [&](){
+                for( uint32_t i = 0; i < items / 2; i++ ) {
+                    full.take();
+                    empty.give();
+                }
+            } };
+
+        for( uint32_t i = 0; i < items; i++ ) {
+            empty.take();
+            full.give();
+        }
+
+        for( auto &t: consumers )
+            t.join();
+        REQUIRE( full.value() == 0 );
+        REQUIRE( empty.value() == 4 );
+    }
+}
+
+TEST_CASE( "RateLimiter token bucket", "[rate_limiter]" ) {
+    SECTION( "burst is available immediately, then bucket is empty" ) {
+        yarn::RateLimiter limiter{ 10, 5 };
+        REQUIRE( limiter.tryAcquire( 5 ) );
+        REQUIRE_FALSE( limiter.tryAcquire() );
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 10 );
+        REQUIRE_THROWS_AS( limiter.acquire_until( 1, deadline ), yarn::TimeoutExpiredException );
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( 120 ) );
+        REQUIRE( limiter.tryAcquire() );
+        REQUIRE_FALSE( limiter.tryAcquire() );
+    }
+
+    SECTION( "blocking acquire keeps rate over many threads" ) {
+        constexpr uint32_t per_thread = 25;
+        yarn::RateLimiter limiter{ 1000, 10 };
+        auto start = std::chrono::steady_clock::now();
+
+        std::array<std::thread, 4> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&limiter](){
+                for( uint32_t i = 0; i < per_thread; i++ )
+                    limiter.acquire();
+            } };
+        for( auto &t: threads )
+            t.join();
+
+        // 100 tokens, 10 of them from burst, rest refilled at 1 per ms
+        REQUIRE( std::chrono::steady_clock::now() - start >= std::chrono::milliseconds( 89 ) );
+    }
+
+    SECTION( "invalid rate is rejected" ) {
+        REQUIRE_THROWS_AS( yarn::RateLimiter( 0, 1 ), std::invalid_argument );
+        REQUIRE_THROWS_AS( yarn::RateLimiter( -5, 1 ), std::invalid_argument );
+        REQUIRE_THROWS_AS( yarn::RateLimiter( std::nan( "" ), 1 ), std::invalid_argument );
+        REQUIRE_THROWS_AS( yarn::RateLimiter( std::numeric_limits<double>::infinity(), 1 ), std::invalid_argument );
+        REQUIRE_THROWS_AS( yarn::RateLimiter( 1e-12, 1 ), std::invalid_argument );
+
+        REQUIRE_THROWS_AS( yarn::RateLimiter( 1e-6, UINT32_MAX ), std::invalid_argument );
+
+        // very slow rate is valid, request longer than 64-bit ns is refused
+        yarn::RateLimiter slow{ 1e-6, 1000 };
+        REQUIRE( slow.tryAcquire( 1000 ) );
+        REQUIRE_FALSE( slow.tryAcquire() );
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 1 );
+        REQUIRE_THROWS_AS( slow.acquire_until( UINT32_MAX, deadline ), yarn::TimeoutExpiredException );
+    }
+}
+
+TEST_CASE( "AdaptiveLimiter adjusts limit", "[adaptive_limiter]" ) {
+    using Algorithm = yarn::AdaptiveLimiter::Algorithm;
+
+    SECTION( "aimd grows without failures and backs off on failure" ) {
+        yarn::AdaptiveLimiter limiter{ Algorithm::aimd, 10, 1, 100, 10 };
+        for( uint32_t i = 0; i < 10; i++ ) {
+            for( uint32_t j = 0; j < 10; j++ )
+                limiter.acquire();
+            for( uint32_t j = 0; j < 10; j++ )
+                limiter.release( 100 );
+        }
+        REQUIRE( limiter.limit() > 10 );
+
+        uint32_t grown = limiter.limit();
+        for( uint32_t j = 0; j < 10; j++ ) {
+            limiter.acquire();
+            limiter.release( 100, true );
+        }
+        REQUIRE( limiter.limit() < grown );
+    }
+
+    SECTION( "gradient shrinks limit when latency grows" ) {
+        yarn::AdaptiveLimiter limiter{ Algorithm::gradient, 50, 1, 100, 10 };
+        for( uint32_t i = 0; i < 20; i++ ) {
+            limiter.acquire();
+            limiter.release( 100 );
+        }
+        uint32_t stable = limiter.limit();
+        REQUIRE( stable >= 50 );
+
+        for( uint32_t i = 0; i < 100; i++ ) {
+            limiter.acquire();
+            limiter.release( 1000 );
+        }
+        REQUIRE( limiter.limit() < stable );
+    }
+
+    SECTION( "decreased limit is enforced when operations finish" ) {
+        yarn::AdaptiveLimiter limiter{ Algorithm::aimd, 4, 1, 100, 4 };
+        for( uint32_t j = 0; j < 4; j++ )
+            limiter.acquire();
+        REQUIRE_FALSE( limiter.tryAcquire() );
+        for( uint32_t j = 0; j < 4; j++ )
+            limiter.release( 100, true );
+
+        uint32_t reduced = limiter.limit();
+        REQUIRE( reduced < 4 );
+        for( uint32_t j = 0; j < reduced; j++ )
+            REQUIRE( limiter.tryAcquire() );
+        REQUIRE_FALSE( limiter.tryAcquire() );
+    }
+
+    SECTION( "concurrent releases close windows without losing permits" ) {
+        constexpr uint32_t rounds = 1 << 13;
+        yarn::AdaptiveLimiter limiter{ Algorithm::aimd, 8, 2, 16, 8 };
+
+        std::array<std::thread, 4> threads;
+        for( uint32_t t = 0; t < threads.size(); t++ )
+            threads[ t ] = std::thread{ [&limiter, t](){
+                for( uint32_t i = 0; i < rounds; i++ ) {
+                    limiter.acquire();
+                    limiter.release( 100 + t, ( i + t ) % 64 == 0 );
+                }
+            } };
+        for( auto &t: threads )
+            t.join();
+
+        // every permit was returned, free permits match limit
+        uint32_t final_limit = limiter.limit();
+        REQUIRE( final_limit >= 2 );
+        REQUIRE( final_limit <= 16 );
+        for( uint32_t j = 0; j < final_limit; j++ )
+            REQUIRE( limiter.tryAcquire() );
+        REQUIRE_FALSE( limiter.tryAcquire() );
+    }
+
+    SECTION( "invalid limits are rejected and initial limit is clamped" ) {
+        REQUIRE_THROWS_AS( ( yarn::AdaptiveLimiter{ Algorithm::aimd, 4, 0, 8 } ), std::invalid_argument );
+        REQUIRE_THROWS_AS( ( yarn::AdaptiveLimiter{ Algorithm::aimd, 4, 16, 8 } ), std::invalid_argument );
+
+        yarn::AdaptiveLimiter low{ Algorithm::aimd, 0, 2, 8 };
+        REQUIRE( low.limit() == 2 );
+        REQUIRE( low.tryAcquire() );
+        REQUIRE( low.tryAcquire() );
+        REQUIRE_FALSE( low.tryAcquire() );
+
+        yarn::AdaptiveLimiter high{ Algorithm::gradient, 100, 2, 8 };
+        REQUIRE( high.limit() == 8 );
+        for( uint32_t j = 0; j < 8; j++ )
+            REQUIRE( high.tryAcquire() );
+        REQUIRE_FALSE( high.tryAcquire() );
+    }
+}
+
+TEST_CASE( "SemaphoreSet atomic acquisition", "[semaphore_set]" ) {
+    yarn::SemaphoreSet set{ { 2, 1, 0 } };
+
+    SECTION( "take is all or nothing" ) {
+        REQUIRE_FALSE( set.tryTake( { { 0, 1 }, { 2, 1 } } ) );
+        REQUIRE( set.value( 0 ) == 2 );
+        REQUIRE_FALSE( set.tryTake( { { 0, 1 }, { 0, 2 } } ) );
+        REQUIRE( set.value( 0 ) == 2 );
+        REQUIRE( set.tryTake( { { 0, 2 }, { 1, 1 } } ) );
+        REQUIRE( set.value( 0 ) == 0 );
+        REQUIRE( set.value( 1 ) == 0 );
+    }
+
+    SECTION( "index out of set is rejected" ) {
+        REQUIRE_THROWS_AS( set.tryTake( { { 0, 1 }, { 3, 1 } } ), std::out_of_range );
+        REQUIRE_THROWS_AS( set.take( { { 7, 1 } } ), std::out_of_range );
+        REQUIRE_THROWS_AS( set.give( { { 0, 1 }, { 3, 1 } } ), std::out_of_range );
+        REQUIRE_THROWS_AS( (void) set.value( 3 ), std::out_of_range );
+        REQUIRE( set.value( 0 ) == 2 );
+    }
+
+    SECTION( "blocked take is woken by give of missing semaphore" ) {
+        bool done = false;
+        std::thread taker{ [&](){
+            set.take( { { 0, 1 }, { 1, 1 }, { 2, 1 } } );
+            done = true;
+        } };
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        REQUIRE( set.value( 0 ) == 2 );
+
+        set.give( { { 2, 1 } } );
+        taker.join();
+        REQUIRE( done );
+        REQUIRE( set.value( 0 ) == 1 );
+        REQUIRE( set.value( 2 ) == 0 );
+    }
+
+    SECTION( "opposite orders do not deadlock" ) {
+        constexpr uint32_t rounds = 1 << 12;
+        set.give( { { 2, 1 } } );
+        auto worker = [&set]( uint32_t first, uint32_t second ){
+            for( uint32_t i = 0; i < rounds; i++ ) {
+                set.take( { { first, 1 }, { second, 1 } } );
+                set.give( { { second, 1 }, { first, 1 } } );
+            }
+        };
+        std::thread a{ worker, 1, 2 }, b{ worker, 2, 1 }, c{ worker, 0, 2 };
+        a.join();
+        b.join();
+        c.join();
+        REQUIRE( set.value( 0 ) == 2 );
+        REQUIRE( set.value( 1 ) == 1 );
+        REQUIRE( set.value( 2 ) == 1 );
+    }
+}
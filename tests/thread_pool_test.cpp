@@ -0,0 +1,152 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include "thread_pool.hpp"
+#include "event_count.hpp"
+#include <thread>
+#include <array>
+#include <vector>
+#include <stdexcept>
+
+
+uint64_t fibonacci( yarn::ThreadPool &pool, uint32_t n ) {
+    if( n < 2 )
+        return n;
+
+    // nested task is pushed to deque of current worker, get helps running tasks meanwhile
+    auto first = pool.submit( [&pool, n](){ return fibonacci( pool, n - 1 ); } );
+    uint64_t second = fibonacci( pool, n - 2 );
+    return first.get() + second;
+}
+
+
+TEST_CASE( "ThreadPool runs submitted tasks", "[thread_pool]" ) {
+    yarn::ThreadPool pool{ 4 };
+    REQUIRE( pool.size() == 4 );
+
+    SECTION( "futures return results" ) {
+        std::vector<yarn::Future<uint32_t>> futures;
+        for( uint32_t i = 0; i < 1000; i++ )
+            futures.push_back( pool.submit( [i](){ return i * i; } ) );
+
+        for( uint32_t i = 0; i < 1000; i++ )
+            REQUIRE( futures[ i ].get() == i * i );
+    }
+
+    SECTION( "exception is rethrown by get" ) {
+        auto future = pool.submit( []() -> int { throw std::runtime_error( "task failed" ); } );
+        REQUIRE_THROWS_AS( future.get(), std::runtime_error );
+
+        auto done = pool.submit( [](){} );
+        done.get();
+        REQUIRE( done.ready() );
+    }
+
+    SECTION( "empty and moved-from futures are not ready and do not block" ) {
+        yarn::Future<int> empty;
+        REQUIRE_FALSE( empty.valid() );
+        REQUIRE_FALSE( empty.ready() );
+        empty.wait();
+
+        auto future = pool.submit( [](){ return 1; } );
+        auto moved = std::move( future );
+        REQUIRE_FALSE( future.ready() );
+        future.wait();
+        REQUIRE( moved.get() == 1 );
+    }
+
+    SECTION( "nested fan-out from workers" ) {
+        auto result = pool.submit( [&pool](){ return fibonacci( pool, 20 ); } );
+        REQUIRE( result.get() == 6765 );
+    }
+
+    SECTION( "many submitting threads" ) {
+        constexpr uint32_t per_thread = 1 << 12;
+        uint32_t counter = 0;
+        std::array<std::thread, 4> threads;
+        for( auto &t: threads )
+            t = std::thread{ [&](){
+                std::vector<yarn::Future<void>> futures;
+                for( uint32_t i = 0; i < per_thread; i++ )
+                    futures.push_back( pool.submit( [&counter](){ __sync_add_and_fetch( &counter, 1 ); } ) );
+                for( auto &future: futures )
+                    future.wait();
+            } };
+
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( counter == per_thread * 4 );
+    }
+}
+
+TEST_CASE( "ThreadPool finishes tasks on destruction", "[thread_pool]" ) {
+    uint32_t counter = 0;
+    {
+        yarn::ThreadPool pool{ 2 };
+        for( uint32_t i = 0; i < 10000; i++ )
+            (void) pool.submit( [&counter](){ __sync_add_and_fetch( &counter, 1 ); } );
+    }
+    REQUIRE( counter == 10000 );
+}
+
+TEST_CASE( "WorkStealingDeque grows and serves both ends", "[thread_pool]" ) {
+    yarn::WorkStealingDeque deque{ 4 };
+    std::array<yarn::Task, 10> tasks{};
+    for( auto &task: tasks )
+        deque.push( &task );
+
+    REQUIRE( deque.steal() == &tasks[ 0 ] );
+    REQUIRE( deque.pop() == &tasks[ 9 ] );
+    for( uint32_t i = 1; i < 9; i++ )
+        REQUIRE( deque.steal() == &tasks[ i ] );
+    REQUIRE( deque.pop() == nullptr );
+    REQUIRE( deque.empty() );
+}
+
+TEST_CASE( "EventCount does not lose wake-ups", "[event_count]" ) {
+    yarn::EventCount event;
+
+    SECTION( "notification after prepare_wait makes commit_wait return" ) {
+        auto key = event.prepare_wait();
+        event.notify_one();
+        event.commit_wait( key );
+
+        key = event.prepare_wait();
+        event.cancel_wait();
+        event.notify_all();
+    }
+
+    SECTION( "consumers of lock-free counter" ) {
+        constexpr uint32_t items = 1 << 14;
+        uint32_t available = 0, consumed = 0;
+
+        auto consumer = [&](){
+            while( true ) {
+                uint32_t current = 0;
+                event.await( [&](){
+                    current = __atomic_load_n( &available, __ATOMIC_ACQUIRE );
+                    return current != 0;
+                } );
+                if( current == UINT32_MAX )
+                    return;
+                if( __sync_bool_compare_and_swap( &available, current, current - 1 ) )
+                    __sync_add_and_fetch( &consumed, 1 );
+            }
+        };
+        std::array<std::thread, 3> threads;
+        for( auto &t: threads )
+            t = std::thread{ consumer };
+
+        for( uint32_t i = 0; i < items; i++ ) {
+            __sync_add_and_fetch( &available, 1 );
+            event.notify_one();
+        }
+        while( __atomic_load_n( &consumed, __ATOMIC_ACQUIRE ) != items )
+            std::this_thread::yield();
+
+        __atomic_store_n( &available, UINT32_MAX, __ATOMIC_RELEASE );
+        event.notify_all();
+        for( auto &t: threads )
+            t.join();
+        REQUIRE( consumed == items );
+    }
+}